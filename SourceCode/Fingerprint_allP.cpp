@@ -0,0 +1,104 @@
+//============================================================================
+// Name        : Fingerprint.cpp
+// Created on  : Oct, 2026
+// Author      :
+// Description :
+//   Module to write the fingerprint log of a simulation: every k steps the
+//   step, the time, a rolling hash of the bit patterns of the network and
+//   the spike count.
+// Used by     : HH_BBT2017_allP.cpp
+//============================================================================
+
+#include "Fingerprint_allP.h"
+
+#include <iostream>     // std::cout
+#include <iomanip>      // std::setw, std::setfill
+#include <cstring>      // memcpy
+#include <limits>
+
+using namespace std;
+
+const uint64_t hashSeed = 0xcbf29ce484222325ull;       // FNV-1a 64 bits offset basis
+
+// Mixing of one 64 bits word
+static inline uint64_t mixWord(uint64_t h, uint64_t w) {
+    w *= 0x9e3779b97f4a7c15ull;
+    w ^= w >> 32;
+    h ^= w;
+    h *= 0x100000001b3ull;                              // FNV-1a 64 bits prime
+    return h ^ (h >> 29);
+}
+
+// Exact bits of one value of the state
+static inline uint64_t hashValue(uint64_t h, const actualDoubleP &x) {
+#ifdef useBoostDoubleP
+    // No access to the digits of cpp_dec_float, its exact decimal
+    // representation is hashed
+    string s = x.str(0, ios_base::scientific);
+    for (unsigned char c : s)
+        h = mixWord(h, c);
+    return h;
+#else
+    // x87 long double uses 10 bytes, the rest of sizeof(long double) is padding
+    const size_t nBytes = numeric_limits<actualDoubleP>::digits == 64 ? 10 : sizeof(actualDoubleP);
+    uint64_t w[2] = {0, 0};
+    memcpy(w, &x, nBytes);
+    h = mixWord(h, w[0]);
+    if (nBytes > 8)
+        h = mixWord(h, w[1]);
+    return h;
+#endif
+}
+
+Fingerprint::Fingerprint(string const fileName, unsigned long every, string const description) {
+
+    if (every<=0) {
+        cerr << "Fingerprint <constructor> parameter wrong!! Value should be integer > 0" << endl;
+        exit(-1);
+    }
+
+    this->every = every;
+    hash = hashSeed;
+    nSpikes = 0;
+
+    cout << "Writing in file: "<< fileName << endl;
+    file.open(fileName);
+    if (!file.is_open())
+        cout << "Unable to open file: "<< fileName << endl;
+
+    file << "# " << description << "\n"
+            << "# precision " << actualPrecisionType << ", every " << every << " steps\n"
+            << "# step\ttime\thash\tspikes\n";
+}
+
+Fingerprint::~Fingerprint() {
+    close();
+}
+
+uint64_t Fingerprint::hashState(uint64_t h, ConstSpan<NeuronState_v_n_a_s> network) {
+    for (const NeuronState_v_n_a_s &x : network)
+        for (int i = 0; i < 4; i++)
+            h = hashValue(h, x[i]);
+    return h;
+}
+
+void Fingerprint::addSpikes(size_t n) {
+    nSpikes += n;
+}
+
+// Called after each step, sim.stepCount() is the index of the step
+void Fingerprint::addStep(const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network) {
+    if ((sim.stepCount()+1) % every != 0)
+        return;
+
+    hash = hashState(hash, network);
+    file << sim.stepCount() << "\t"
+            << fixed << setprecision(2) << (double) sim.time() << "\t"
+            << hex << setw(16) << setfill('0') << hash << dec << setfill(' ') << "\t"
+            << nSpikes << "\n";
+}
+
+void Fingerprint::close() {
+    if (file.is_open())
+        file.close();
+}
@@ -0,0 +1,38 @@
+#ifndef FINGERPRINT_H_
+#define FINGERPRINT_H_
+
+#include <string>               // std::string, std::to_string
+#include <fstream>              // std::ofstream
+#include <cstdint>              // uint64_t
+
+#include "checkActualPrecision.h"
+#include "Simulation_allP.h"
+
+using namespace std;
+
+// Rolling hash of the exact bit patterns of the network, logged every k steps
+// with the spike count, to compare runs on different platforms without
+// copying the trace and spike files (a few KB instead of GB).
+// The hash of each logged step is chained with the previous one: once two
+// runs differ all the following hashes differ, so the first differing step
+// can be found by binary search (see compareFingerprint_allP.cpp).
+class Fingerprint {
+    ofstream file;
+    unsigned long every;                    // Log every k steps
+    uint64_t hash;
+    unsigned long nSpikes;                  // Spikes since t = 0
+
+public:
+    Fingerprint(string const fileName, unsigned long every, string const description);
+    virtual ~Fingerprint();
+
+    void addSpikes(size_t n);
+    void addStep(const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network);
+
+    // Hash of the network state chained with h
+    static uint64_t hashState(uint64_t h, ConstSpan<NeuronState_v_n_a_s> network);
+
+    void close();
+};
+
+#endif /* FINGERPRINT_H_ */
@@ -0,0 +1,243 @@
+#ifndef HHMODEL_H_
+#define HHMODEL_H_
+
+// Hodgkin-Huxley (reduced) neuron with synaptic depression
+// From Tabak, Mascagni, Bertram. J Neurophysiol, 103:2208-2221, 2010.
+// Constants and rate functions shared by the simulation modules
+
+#include <string>       // std::string, std::to_string
+#include <cmath>        // pow, exp
+
+#include <boost/array.hpp>
+
+#include "checkActualPrecision.h"
+#ifdef useDetExp
+    #include "detExp_allP.h"
+#endif
+#if defined(useBoostDoubleP) && !defined(useBoostLibExp)
+    #include "boostExp_allP.h"
+#endif
+
+using namespace std;
+
+//# v[i] membrane potential of cell i
+//# n[i] activation of K+ conductance for cell i
+//# a[i] synaptic drive from cell i
+//# s[i] synaptic recovery for terminals from cell i
+typedef boost::array<actualDoubleP, 4> NeuronState_v_n_a_s;
+typedef boost::array<accumDoubleP, 4> myArrayDouble4;     // Network averages
+typedef boost::array<episodeDoubleP, 4> myEpisodeDouble4; // Episodes: Aexc, Ainh, +/-time episode, 1
+
+// Cellular parameters
+// p deli=15
+// p vna=115  vk=-12  vl=10.6  gnabar=36  gkbar=12  gl=0.1
+// p h0=0.8
+// Declared in the actual precision, so the model is evaluated in it without
+// conversions (ex: float is not promoted to double)
+const double deli=15.0;
+const actualDoubleP vna=115.0;
+const actualDoubleP vk = -12.0;
+const actualDoubleP vl=10.6;
+const actualDoubleP gnabar=36.0;
+const actualDoubleP gkbar=12.0;
+const actualDoubleP gl=0.1;
+const actualDoubleP h0=0.8;
+
+// Synaptic parameters
+// p taus=10 tauf=1
+// p gsyn=3.6 vsyn=70
+// p alphad=0.0015 betad=0.12
+// p Vthresh=40 kv=1
+const actualDoubleP taus=10.0;
+const actualDoubleP tauf=1.0;
+const double gsynTotal=3.6;                     // gsyn = gsynTotal/nNeurons
+const actualDoubleP alphad=0.0015;
+const actualDoubleP betad=0.12;
+const actualDoubleP Vthresh=40.0;
+constexpr double kvModel=1.0;                   // Known at compile time, selects the step kernel
+const actualDoubleP kv=kvModel;
+
+// Parameters needed to detect episodes
+const double thA = 0.1730;                                      // thA = 0.25*(maxAt-minAt); based on Patrick paper. Previous calculated in Matlab
+const double thDA = 0.1490;
+
+// Coefficients of the rate functions
+const actualDoubleP am_c=.1, bm_c=4.0, an_c=.01, bn_c=.125, one_c=1.0;
+
+#ifdef useBoostDoubleP
+// Constants of the Boost kernel: in the Boost precision a division costs
+// about 8 products, the divisions by constants are replaced by products by
+// the reciprocals, and exp(am_c*(10-v)) = exp(am_c*(25-v))*exp(-15*am_c)
+// (am_c is the double .1, as in the other precisions)
+const actualDoubleP mInv18_c = actualDoubleP(-1)/18, mInv80_c = actualDoubleP(-1)/80;
+const actualDoubleP invTauf_c = one_c/tauf, invTaus_c = one_c/taus;
+const actualDoubleP expM15_c = exp(-15*am_c);
+#endif
+
+// Parameter sets known at compile time, used to generate step kernels
+// without the work that a given configuration does not need
+template <bool inhibitory, bool unitKv>
+struct KernelParams {
+    static constexpr bool hasInhNeurons = inhibitory;   // false: pExcNeurons = 1, no inhibitory synapses
+    static constexpr bool kvIsOne = unitKv;             // true: fsyn without the division by kv
+
+    static string name() {
+        return string(inhibitory ? "mixed E/I" : "pure excitatory") + (unitKv ? ", kv = 1" : ", generic kv");
+    }
+};
+
+typedef KernelParams<false, true> PureExcKernel;        // pExcNeurons = 1, kv = 1
+typedef KernelParams<true, true>  MixedKernel;          // pExcNeurons < 1, kv = 1
+typedef KernelParams<true, false> GenericKernel;        // Any configuration (fallback)
+
+// Calls f with the kernel for the actual configuration (a KernelParams
+// value), the same selection for the simulation loop and its name.
+// -DuseGenericKernel always selects the fallback, to test it with kv = 1
+template <class F>
+inline auto selectKernel(const unsigned int nInhNeurons, F f) {
+#ifndef useGenericKernel
+    if constexpr (kvModel == 1.0) {
+        if (nInhNeurons == 0)
+            return f(PureExcKernel());
+        else
+            return f(MixedKernel());
+    } else
+#endif
+        return f(GenericKernel());
+}
+
+// Math backend for the exponentials of the model: the system libm
+// (std::exp) or, with -DuseDetExp, the bundled deterministic implementation
+// that gives the same bits on every platform. The Boost precision uses the
+// table driven exp of boostExp_allP.h (-DuseBoostLibExp: the Boost one)
+inline void modelExp(actualDoubleP *x, const int n) {
+#if defined(useBoostDoubleP) && !defined(useBoostLibExp)
+    for (int i = 0; i < n; i++)
+        x[i] = boostExp(x[i]);
+#elif defined(useDetExp)
+    #if defined(__AVX__)
+        detExp(x, x, n);                    // SIMD version, 4 values at a time
+    #else
+        for (int i = 0; i < n; i++)         // For 5 values the 2 lanes SIMD version is slower
+            x[i] = detExp(x[i]);
+    #endif
+#else
+    for (int i = 0; i < n; i++)
+        x[i] = exp(x[i]);
+#endif
+}
+
+// Rate constants and synaptic activation at a membrane potential v
+struct HHRates {
+    actualDoubleP am, bm, an, bn, fsyn;
+};
+
+// The five exponentials are evaluated together, once per call (Boost: four)
+template <class P>
+inline void hhRates (const actualDoubleP v, HHRates &r) {
+    actualDoubleP e[5];
+
+    e[0] = am_c*(25-v);
+#ifdef useBoostDoubleP
+    e[1] = v*mInv18_c;
+    e[3] = v*mInv80_c;
+#else
+    e[1] = -v/18;
+    e[2] = am_c*(10-v);
+    e[3] = -v/80;
+#endif
+    if constexpr (P::kvIsOne)
+        e[4] = Vthresh-v;                   // if kv = 1;
+    else
+        e[4] = (Vthresh-v)/kv;
+#ifdef useBoostDoubleP
+    modelExp(e, 2);
+    modelExp(e+3, 2);
+    e[2] = e[0]*expM15_c;
+#else
+    modelExp(e, 5);
+#endif
+
+    // Rate constants for Na+ and K+ currents
+    // am(v)=.1*(25-v)/(exp(.1*(25-v))-1)
+    r.am = am_c*(25-v)/(e[0]-1);
+    // bm(v)=4.0*exp(-v/18)
+    r.bm = bm_c*e[1];
+    // an(v)=.01*(10-v)/(exp(.1*(10-v))-1.0)
+    r.an = an_c*(10-v)/(e[2]-one_c);
+    // bn(v)=.125*exp(-v/80)
+    r.bn = bn_c*e[3];
+
+#if defined(useFloatP) || defined(useMixedP)
+    // am and an are x/(exp(x)-1) with a removable singularity at x = 0
+    // (v = 25 and v = 10). In single precision v reaches those values and
+    // exp(x)-1 cancels to 0, the series 1-x/2+x^2/12 is used near 0
+    const actualDoubleP xSing = 1e-2f;
+    actualDoubleP x = am_c*(25-v);
+    if (abs(x) < xSing)
+        r.am = 1 - x/2 + x*x/12;
+    x = am_c*(10-v);
+    if (abs(x) < xSing)
+        r.an = am_c*(1 - x/2 + x*x/12);
+#endif
+
+    // Synaptic activation
+    //fsyn(V) = 1./(1+exp((Vthresh-V)/kv))
+    r.fsyn = one_c/(1+e[4]);
+}
+
+// Steady state activation function for Na+ current
+// minf(v)=am(v)/(am(v)+bm(v))
+inline actualDoubleP minf (const HHRates &r) {
+    return r.am/(r.am+r.bm);
+}
+
+// Integer powers of the gating variables. In single precision pow(float,int)
+// would return double, the products keep the computation in float; with
+// -DuseDetExp they avoid the pow of the platform libm
+template <int k>
+inline actualDoubleP powGate (const actualDoubleP &x) {
+#if defined(useFloatP) || defined(useMixedP) || defined(useDetExp)
+    actualDoubleP y = x;
+    for (int i = 1; i < k; i++)
+        y *= x;
+    return y;
+#else
+    return pow(x, k);
+#endif
+}
+
+// n, a and s are linear in themselves for a fixed v: w' = alpha(v) - beta(v)*w
+// n'= an-(an+bn)*n
+// a'= fsyn/tauf - (fsyn/tauf+1/taus)*a
+// s'= alphad - (alphad+betad*fsyn)*s
+struct GateRates {
+    actualDoubleP alpha[3], beta[3];        // n, a, s
+};
+
+inline void hhGateRates (const HHRates &r, GateRates &g) {
+    g.alpha[0] = r.an;
+    g.beta[0] = r.an+r.bn;
+    g.alpha[1] = r.fsyn/tauf;
+    g.beta[1] = r.fsyn/tauf + one_c/taus;
+    g.alpha[2] = alphad;
+    g.beta[2] = alphad+betad*r.fsyn;
+}
+
+// Exact solution of the linear equations of n, a and s after a time h with
+// frozen rates (Rush-Larsen): w(h) = winf + (w(0)-winf)*exp(-beta*h), winf = alpha/beta.
+// Stable for any h, w tends to winf. x and y can be the same state
+inline void rushLarsenGates (const NeuronState_v_n_a_s &x, const GateRates &g, const actualDoubleP h,
+                                NeuronState_v_n_a_s &y) {
+    actualDoubleP e[3];
+
+    for (int i = 0; i < 3; i++)
+        e[i] = -g.beta[i]*h;
+    modelExp(e, 3);
+    for (int i = 0; i < 3; i++) {
+        actualDoubleP winf = g.alpha[i]/g.beta[i];
+        y[i+1] = winf + (x[i+1]-winf)*e[i];
+    }
+}
+
+#endif /* HHMODEL_H_ */
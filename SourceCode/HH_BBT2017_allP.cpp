@@ -17,224 +17,70 @@
 #include <iostream>     // std::cout
 #include <fstream>      // std::ofstream
 #include <string>       // std::string, std::to_string
-#include <cmath>        // pow
+#include <cmath>        // abs
 #include <time.h>
 #include <filesystem>
+#include <limits>       // numeric_limits
+#include <algorithm>    // std::min
+#include <sstream>      // std::istringstream
 
 #include <sys/stat.h>
 #include <stdio.h>
 
-#include <boost/array.hpp>
-#include <boost/numeric/odeint.hpp>
 #include <boost/multiprecision/cpp_dec_float.hpp>
 
 #include "checkActualPrecision.h"
-#include "SpikeTrain_allP.h"
+#include "Simulation_allP.h"
+#include "ResultWriter_allP.h"
+#include "Fingerprint_allP.h"
+#include "Parareal_allP.h"
+#include "Lyapunov_allP.h"
+#include "Sweep_allP.h"
 #include "iappDist_allP.h"
 
 using namespace std;
 
-using namespace boost::numeric::odeint;
 using namespace boost::multiprecision;
 
 // Simulation constants
-const unsigned int nNeurons = 100;
-const double dt = 0.01;                         // Time step: ms
-const double maxTimeSimulation = 8000;          // Maximum simulation time: ms
 const bool SAVE_SIMULATION = true;
 const int n_precision = 14;
 const string outputDir  = "./results";
+const size_t writerChunkSize = 4096;            // Rows per buffer of the result writer
 
-// Simulation parameters
-double pExcNeurons = 1;                                         // Percentage of excitatory neurons
-unsigned int nExcNeurons = (unsigned int) nNeurons*pExcNeurons; // Amount of excitatory neurons
-unsigned int nInhNeurons = nNeurons-nExcNeurons;                // Amount of inhibitory neurons
-unsigned int maxNumBurst = 200;                                 // Amount of burst to be reached to stop the simulation
-
-// Parameters needed to detect episodes
-const double thA = 0.1730;                                      // thA = 0.25*(maxAt-minAt); based on Patrick paper. Previous calculated in Matlab
-const double thDA = 0.1490;
-bool activePhase;
-unsigned int burstCount;
-
-// Parameters needed to detect spikes
-bool depolarization[nNeurons];
-
-// Cellular parameters
-// p deli=15
-// p vna=115  vk=-12  vl=10.6  gnabar=36  gkbar=12  gl=0.1
-// p h0=0.8
-const double deli=15.0;
-const double vna=115.0;
-const double vk = -12.0;
-const double vl=10.6;
-const double gnabar=36.0;
-const double gkbar=12.0;
-const double gl=0.1;
-const double h0=0.8;
-
-// p vexc=70
-// p vinh = -12
-double vExc = 70.0;
-double vInh = -12.0;
-double vsyn = 70.0;
-
-// Synaptic parameters
-// p taus=10 tauf=1
-// p gsyn=3.6 vsyn=70
-// p alphad=0.0015 betad=0.12
-// p Vthresh=40 kv=1
-const double taus=10.0;
-const double tauf=1.0;
-const double gsyn=3.6/nNeurons;
-const double alphad=0.0015;
-const double betad=0.12;
-const double Vthresh=40.0;
-const double kv=1.0;
-
-//# Create a table of applied currents Ii
-// Table iapp % 100 0 99 i0+t*deli/99
-vector<actualDoubleP> iapp(nNeurons);                   // for Excitatory neurons
-actualDoubleP iappj;
-
-//# Synaptic drive from excitatory cells
-actualDoubleP atotExc, atotExcj;
-//# Synaptic drive from inhibitory cells
-actualDoubleP atotInh, atotInhj;
-
-//# v[i] membrane potential of cell i
-//# n[i] activation of K+ conductance for cell i
-//# a[i] synaptic drive from cell i
-//# s[i] synaptic recovery for terminals from cell i
-typedef boost::array<actualDoubleP, 4> NeuronState_v_n_a_s;
-typedef boost::array<actualDoubleP, 4> myArrayDouble4;
-
-// Vector of neurons -> The Network
-vector<NeuronState_v_n_a_s> network(nNeurons);
-
-// SpikeTrain Class to manage/store/save the spike times for each neuron
-SpikeTrain *mSpikeTrain = new SpikeTrain(nNeurons);
-
-// Auxiliary variables for output
-vector<NeuronState_v_n_a_s> ave;            // Average of V N A and S
-vector<myArrayDouble4> networkOutputs;      // Average Ainh and Aexc, episodes time,
+// Simulation parameters, see SimulationParameters for the default values
+SimulationParameters param;
 
-//==========
-// Functions
-//==========
-
-// Rate constants and steady state activation function for Na+ and K+ currents
-// am(v)=.1*(25-v)/(exp(.1*(25-v))-1)
-inline actualDoubleP am (const actualDoubleP v) {
-   return .1*(25-v)/(exp(.1*(25-v))-1);
-}
-
-// bm(v)=4.0*exp(-v/18)
-inline actualDoubleP bm (const actualDoubleP v) {
-    return 4.0*exp(-v/18);
-}
+// ResultWriter Class to stream the average trace, episodes and spike times to disk
+ResultWriter *mResultWriter = NULL;
 
-// minf(v)=am(v)/(am(v)+bm(v))
-inline actualDoubleP minf (const actualDoubleP v) {
-    return am(v)/(am(v)+bm(v));
-}
+// Fingerprint log to compare runs of different platforms, every k steps (0: disabled)
+unsigned long fingerprintEvery = 0;
+Fingerprint *mFingerprint = NULL;
 
-// bn(v)=.125*exp(-v/80)
-inline actualDoubleP bn (const actualDoubleP v) {
-    return .125*exp(-v/80);
-}
+// Window of steps [traceFrom .. traceTo] with the full state of every neuron
+// (-1: disabled), to inspect the first differing step of two fingerprints
+long traceFrom = -1;
+long traceTo = -1;
+ofstream windowFile;
 
-// an(v)=.01*(10-v)/(exp(.1*(10-v))-1.0)
-inline actualDoubleP an (const actualDoubleP v) {
-    return .01*(10-v)/(exp(.1*(10-v))-1.0);
-}
+// Leading Lyapunov exponents (0: disabled), orthonormalized every m steps
+unsigned int lyapunovExponents = 0;
+unsigned long lyapunovRenorm = 10;
+Lyapunov *mLyapunov = NULL;
 
-// Synaptic activation
-//fsyn(V) = 1./(1+exp((Vthresh-V)/kv))
-inline actualDoubleP fsyn (const actualDoubleP v) {
-    //return 1.0/(1+exp((Vthresh-v)/kv));
-    return 1.0/(1+exp(Vthresh-v)); // if kv = 1;
-}
+// Parareal time-parallel integration (experimental), 0 windows: disabled
+PararealParameters pararealParam = {0};
+bool pararealCheck = false;                     // Also run the serial simulation to compare
 
-// System ODEs per Neuron
-// This function uses the following global variables 
-//  vna=115.0;
-//  vk = -12.0;
-//	vl=10.6;
-//	gnabar=36.0;
-//	gkbar=12.0;
-//	gl=0.1;
-//	h0=0.8;
-//  iappj;
-//  gsyn=3.6/nNeurons;
-void HH_NeuronModel( const NeuronState_v_n_a_s &x , NeuronState_v_n_a_s &dxdt , long double t )
-{
-    actualDoubleP vj = x[0];
-    actualDoubleP nj = x[1];
-    actualDoubleP aj = x[2];
-    actualDoubleP sj = x[3];
-
-    // Differential equations (XPP original version)
-    // v[i] membrane potential of cell i
-    // v[0..99]'= -gl*(v[j]-vl)
-    //              -gnabar*minf(v[j])^3*(h0-n[j])*(v[j]-vna)
-    //              -gkbar*n[j]^4*(v[j]-vk)
-    //              -gsyn*(atot-a[j]*s[j]/100)*(v[j]-vsyn)
-    //              +iapp([j])
-    dxdt[0] = -gl*(vj-vl)
-                    -gnabar*pow(minf(vj),3)*(h0-nj)*(vj-vna)
-                    -gkbar*pow(nj,4)*(vj-vk)
-                    -gsyn*atotExcj*(vj-vExc)
-                    -gsyn*atotInhj*(vj-vInh)
-                    +iappj;
-
-    // n[i] Activation of K+ conductance for cell i
-    // n[0..99]'= an(v[j])-(an(v[j])+bn(v[j]))*n[j]
-    dxdt[1] = an(vj)-(an(vj)+bn(vj))*nj;
-
-    // a[i] Synaptic drive from cell i
-    // a[0..99]'= fsyn(v[j])*(1-a[j])/tauf - a[j]/taus
-    dxdt[2] = fsyn(vj)*(1-aj)/tauf - aj/taus;
-
-    // s[i] Synaptic recovery for terminals from cell i
-    // s[0..99]'=alphad*(1-s[j])-betad*fsyn(v[j])*s[j]
-    dxdt[3] = alphad*(1-sj)-betad*fsyn(vj)*sj;
-}
+// Continuation sweep over vInh or pExcN (no values: disabled)
+SweepParameters sweepParam;
 
-void initEachNeuron( void) {
-    // Initial conditions
-    // init v[0..99]=0 n[j]=0 a[j]=0.01 s[j]=.25
-    for (unsigned int n = 0; n < nNeurons; n++) {
-    	network[n][0]= 0.0;			// v
-    	network[n][1]= 0.0; 		// n
-    	network[n][2]= 0.01; 		// a
-    	network[n][3]= 0.25;		// s
-        depolarization[n]=false; 	// no spike found
-    }
-}
-
-// Function to write a .txt file with the output parameters of the network state
-int writeToFile (string const fileNameStr, vector<NeuronState_v_n_a_s> &v) {
-
-    ofstream myfile(fileNameStr);
-    cout << "Writing in file: "<< fileNameStr << endl;
-
-    myfile.precision(n_precision);                              // Adjust precision
-    myfile.setf( std::ios::fixed, std::ios::floatfield );
-    if (myfile.is_open()) {
-        if (v.size() > 0) {
-            for (unsigned int i=0; i<v.size();i++) {
-                myfile << v[i][0] << '\t' << v[i][1] << '\t' << v[i][2] << '\t' << v[i][3] << '\n';
-            }
-            myfile.close();
-        }
-    } else 
-        cout << "Unable to open file: "<< fileNameStr << endl;
-
-    return 0;
-}
+//==========
+// Functions
+//==========
 
-void showParameters( ) {
+void showParameters(const Simulation &sim) {
     cout << "gcc version: "<< __GNUC__<<"."<<__GNUC_MINOR__<<"."<<__GNUC_PATCHLEVEL__<<endl;
     cout << "Sizes (bytes):\n"
             <<"Double = "<< sizeof(double)
@@ -243,15 +89,24 @@ void showParameters( ) {
     cout << "Actual float-point type : "<< actualPrecisionType << "\n\n";;
     
     cout << "Running with the parameters:\n"
-            << "Total Neurons = "<< to_string(nNeurons) << "\n"
-            << "Exc Neurons = "<< to_string(nExcNeurons) << "\n"
-            << "Inh Neurons = "<< to_string(nInhNeurons) << "\n"
-            << "maxTimeSimulation = "<< to_string(maxTimeSimulation/1000) << " s\n"
-            << "nBurst = "<< to_string(maxNumBurst) << "\n"
-            << "dt = "<< to_string(dt) << " ms\n"
-            << "vInh = "<< to_string(vInh) << "\n"
+            << "Total Neurons = "<< to_string(param.nNeurons) << "\n"
+            << "Exc Neurons = "<< to_string(sim.nExcNeurons()) << "\n"
+            << "Inh Neurons = "<< to_string(sim.nInhNeurons()) << "\n"
+            << "maxTimeSimulation = "<< to_string(param.maxTimeSimulation/1000) << " s\n"
+            << "nBurst = "<< to_string(param.maxNumBurst) << "\n"
+            << "dt = "<< to_string(param.dt) << " ms\n"
+            << "Solver = "<< sim.solverName() << "\n"
+            << "vInh = "<< to_string(param.vInh) << "\n"
             << "Set precision = "<< to_string(n_precision) << "\n"
             << "SAVE_SIMULATION = "<< to_string(SAVE_SIMULATION) << "\n"
+            << "Writer chunk size = "<< to_string(writerChunkSize) << " rows\n"
+            << "Step kernel = "<< sim.kernelName() << "\n"
+            << "Fingerprint every = "<< to_string(fingerprintEvery) << " steps\n"
+            << "Trace window = ["<< to_string(traceFrom) << " .. " << to_string(traceTo) << "] steps\n"
+            << "Lyapunov exponents = "<< to_string(lyapunovExponents) << ", orthonormalized every " << to_string(lyapunovRenorm) << " steps\n"
+            << "Parareal windows = "<< to_string(pararealParam.nWindows) << "\n"
+            << "Sweep points = "<< to_string(sweepParam.values.size()) << ", "
+            << to_string(sweepParam.transientBursts) << " transient bursts per point\n"
             << endl;
 }
 
@@ -263,9 +118,41 @@ void showUsage(string name)
             << "\t-vInh\t<Reversal Potential value, double [-12 .. 70]>\n"
             << "\t-nBurst\t<How many burst, integer > 0>\n"
             << "\t-pExcN\t<Persentage of excitatory neurons, double ]0..1]>\n"
+            << "\t-solver\t<rk4 (default) or rl2 (Rush-Larsen, exponential n, a, s)>\n"
+            << "\t-dt\t<Time step, ms, double > 0, default 0.01>\n"
+            << "\t-fingerprint\t<Log the state hash every k steps, integer > 0>\n"
+            << "\t-traceFrom\t<First step of the full state window, integer >= 0>\n"
+            << "\t-traceTo\t<Last step of the full state window, the simulation stops there>\n"
+            << "\t-lyapunov\t<Estimate the k leading Lyapunov exponents, integer > 0>\n"
+            << "\t-lyapRenorm\t<Steps between orthonormalizations of the tangent vectors, integer > 0, default 10>\n"
+            << "\t-parareal\t<Parareal integration with n time windows, integer > 0 (experimental)>\n"
+            << "\t-pararealCoarse\t<Coarse dt = m*dt, integer > 0, default 10>\n"
+            << "\t-pararealThreads\t<Threads for the fine solves, default all the cores>\n"
+            << "\t-pararealTol\t<Max boundary change to stop iterating, double >= 0, default 1e-6>\n"
+            << "\t-pararealIter\t<Max iterations, integer > 0, default the number of windows>\n"
+            << "\t-pararealCheck\t<1: run the serial simulation and compare>\n"
+            << "\t-sweepVInh\t<Continuation sweep over vInh, comma separated values \"v1,v2,...\">\n"
+            << "\t-sweepPExcN\t<Continuation sweep over pExcN, comma separated values \"p1,p2,...\">\n"
+            << "\t-transientBursts\t<Bursts skipped at the start of each sweep point, integer >= 0, default 0>\n"
+            << "\t-sweepJump\t<Relative change of the mean IBI/duration flagged, double > 0, default 0.25>\n"
+            << "\t-sweepCold\t<1: each sweep point from the initial conditions (to compare)>\n"
             << endl;
 }
 
+// Comma separated list of doubles, false if a value is not a number
+bool parseValues(const char *arg, vector<double> &values) {
+    istringstream in(arg);
+    string token;
+    values.clear();
+    while (getline(in, token, ',')) {
+        char *end;
+        values.push_back(strtod(token.c_str(), &end));
+        if (end == token.c_str())
+            return false;
+    }
+    return !values.empty();
+}
+
 int parseParameters(int argc, char* argv[]) {
 
     if (argc < 2) {
@@ -276,8 +163,8 @@ int parseParameters(int argc, char* argv[]) {
     for (int i = 1; i < argc; i+=2) {
         if (string(argv[i]) == "-vInh") {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
-                vInh = strtod(argv[i + 1], NULL); // [70 ..-12]
-                if (vInh<-12.0 || vInh>70.0) {
+                param.vInh = strtod(argv[i + 1], NULL); // [70 ..-12]
+                if (param.vInh<-12.0 || param.vInh>70.0) {
                     std::cerr << "-vInh option requires double argument [-12..70]." << std::endl;
                     return -1;
                 }
@@ -288,7 +175,7 @@ int parseParameters(int argc, char* argv[]) {
         }
         if (string(argv[i]) == "-nBurst") {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
-                maxNumBurst = strtod(argv[i + 1],NULL); // Increment 'i' so we don't get the argument as the next argv[i].
+                param.maxNumBurst = strtod(argv[i + 1],NULL); // Increment 'i' so we don't get the argument as the next argv[i].
             } else { // Uh-oh, there was no argument to the destination option.
                 std::cerr << "-nBurst option requires one argument." << std::endl;
                 return -1;
@@ -296,8 +183,8 @@ int parseParameters(int argc, char* argv[]) {
         }
         if (string(argv[i]) == "-pExcN") {
             if (i + 1 < argc) { // Make sure we aren't at the end of argv!
-                pExcNeurons = strtod(argv[i + 1],NULL); // Increment 'i' so we don't get the argument as the next argv[i].
-                if (pExcNeurons<=0 || pExcNeurons>1) {
+                param.pExcNeurons = strtod(argv[i + 1],NULL); // Increment 'i' so we don't get the argument as the next argv[i].
+                if (param.pExcNeurons<=0 || param.pExcNeurons>1) {
                     std::cerr << "-pExcN option requires double argument ]0..1]." << std::endl;
                     return -1;
                 }
@@ -306,6 +193,210 @@ int parseParameters(int argc, char* argv[]) {
                 return -1;
             }
         }
+        if (string(argv[i]) == "-solver") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                string solver = argv[i + 1];
+                if (solver == "rk4")
+                    param.solver = Solver::RK4;
+                else if (solver == "rl2")
+                    param.solver = Solver::RL2;
+                else {
+                    std::cerr << "-solver option requires argument rk4 or rl2." << std::endl;
+                    return -1;
+                }
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-solver option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-dt") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                param.dt = strtod(argv[i + 1],NULL);
+                if (param.dt<=0) {
+                    std::cerr << "-dt option requires double argument > 0." << std::endl;
+                    return -1;
+                }
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-dt option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-fingerprint") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                fingerprintEvery = strtoul(argv[i + 1],NULL,10);
+                if (fingerprintEvery<=0) {
+                    std::cerr << "-fingerprint option requires integer argument > 0." << std::endl;
+                    return -1;
+                }
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-fingerprint option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-traceFrom") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                traceFrom = strtol(argv[i + 1],NULL,10);
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-traceFrom option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-traceTo") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                traceTo = strtol(argv[i + 1],NULL,10);
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-traceTo option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-lyapunov") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                lyapunovExponents = strtoul(argv[i + 1],NULL,10);
+                if (lyapunovExponents<=0) {
+                    std::cerr << "-lyapunov option requires integer argument > 0." << std::endl;
+                    return -1;
+                }
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-lyapunov option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-lyapRenorm") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                lyapunovRenorm = strtoul(argv[i + 1],NULL,10);
+                if (lyapunovRenorm<=0) {
+                    std::cerr << "-lyapRenorm option requires integer argument > 0." << std::endl;
+                    return -1;
+                }
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-lyapRenorm option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-parareal") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                pararealParam.nWindows = strtoul(argv[i + 1],NULL,10);
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-parareal option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-pararealCoarse") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                pararealParam.coarseFactor = strtoul(argv[i + 1],NULL,10);
+                if (pararealParam.coarseFactor<=0) {
+                    std::cerr << "-pararealCoarse option requires integer argument > 0." << std::endl;
+                    return -1;
+                }
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-pararealCoarse option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-pararealThreads") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                pararealParam.nThreads = strtoul(argv[i + 1],NULL,10);
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-pararealThreads option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-pararealTol") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                pararealParam.tol = strtod(argv[i + 1],NULL);
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-pararealTol option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-pararealIter") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                pararealParam.maxIterations = strtoul(argv[i + 1],NULL,10);
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-pararealIter option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-pararealCheck") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                pararealCheck = strtol(argv[i + 1],NULL,10) != 0;
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-pararealCheck option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-sweepVInh" || string(argv[i]) == "-sweepPExcN") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                bool vInhSweep = string(argv[i]) == "-sweepVInh";
+                if (!sweepParam.values.empty()) {
+                    std::cerr << "Only one of -sweepVInh and -sweepPExcN options can be used." << std::endl;
+                    return -1;
+                }
+                if (!parseValues(argv[i + 1], sweepParam.values)) {
+                    std::cerr << argv[i] << " option requires comma separated double values." << std::endl;
+                    return -1;
+                }
+                for (double v : sweepParam.values)
+                    if (vInhSweep ? (v<-12.0 || v>70.0) : (v<=0 || v>1)) {
+                        std::cerr << argv[i] << " option requires values " << (vInhSweep ? "[-12..70]." : "]0..1].") << std::endl;
+                        return -1;
+                    }
+                sweepParam.variable = vInhSweep ? SweepVariable::VInh : SweepVariable::PExcN;
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << argv[i] << " option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-transientBursts") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                long k = strtol(argv[i + 1],NULL,10);
+                if (k<0) {
+                    std::cerr << "-transientBursts option requires integer argument >= 0." << std::endl;
+                    return -1;
+                }
+                sweepParam.transientBursts = k;
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-transientBursts option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-sweepJump") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                sweepParam.jump = strtod(argv[i + 1],NULL);
+                if (sweepParam.jump<=0) {
+                    std::cerr << "-sweepJump option requires double argument > 0." << std::endl;
+                    return -1;
+                }
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-sweepJump option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+        if (string(argv[i]) == "-sweepCold") {
+            if (i + 1 < argc) { // Make sure we aren't at the end of argv!
+                sweepParam.cold = strtol(argv[i + 1],NULL,10) != 0;
+            } else { // Uh-oh, there was no argument to the destination option.
+                std::cerr << "-sweepCold option requires one argument." << std::endl;
+                return -1;
+            }
+        }
+    }
+
+    if (!sweepParam.values.empty() && (pararealParam.nWindows > 0 || fingerprintEvery > 0 || traceTo >= 0 || lyapunovExponents > 0)) {
+        std::cerr << "-parareal, -fingerprint, -traceFrom/-traceTo and -lyapunov options are not available with -sweepVInh/-sweepPExcN." << std::endl;
+        return -1;
+    }
+    if (pararealParam.nWindows > 0 && (fingerprintEvery > 0 || traceTo >= 0 || lyapunovExponents > 0)) {
+        std::cerr << "-fingerprint, -traceFrom/-traceTo and -lyapunov options are not available with -parareal." << std::endl;
+        return -1;
+    }
+    if (lyapunovExponents > 0 && param.solver != Solver::RK4) {  // The tangent vectors follow the RK4 step
+        std::cerr << "-lyapunov option is only available with -solver rk4." << std::endl;
+        return -1;
+    }
+    if ((traceFrom>=0 || traceTo>=0) && (traceFrom<0 || traceTo<traceFrom)) {
+        std::cerr << "-traceFrom and -traceTo options require integer arguments 0 <= traceFrom <= traceTo." << std::endl;
+        return -1;
     }
 
     return 1;
@@ -333,25 +424,31 @@ void directory_existsCreate(const filesystem::path& p,
         
 }
 
+// Continuation sweep, it writes the statistics of each point in
+// *_Sweep.txt instead of the trace, episode and spike files
+void runSweep(const Simulation &sim) {
+    Sweep sweep(param, sweepParam);
+    string sdt = "dt0" + to_string(lround(param.dt*10000)) + "_";
+    string description = "HH_BBT " + sim.solverName() + "_" + sdt + to_string(param.nNeurons) +
+            ",sweep " + sweep.variableName() + " " + to_string(sweepParam.values.size()) + " points";
+    string fileNameStr = outputDir + "/HH_BBT_" +
+            sim.solverName() + "_" + sdt +
+            to_string(param.nNeurons) + "," +
+            (sweepParam.variable == SweepVariable::PExcN ? "sweepPExcN," : "sweepVInh,") +
+            to_string(sweepParam.values.size()) + "pts,t=" +
+            to_string((int)(param.maxTimeSimulation/1000)) + "s_" +
+            actualPrecisionType + (sweepParam.cold ? "_cold" : "");
 
-int main(int argc, char* argv[]) {
-
-    unsigned int n;
-    long double t;
-    actualDoubleP actTotalExc;
-    actualDoubleP actTotalInh;
-    actualDoubleP v_1;
-    actualDoubleP s_t;
-    actualDoubleP sTotalExc;
-    actualDoubleP sTotalInh;
-
-    NeuronState_v_n_a_s sN_1;
-    NeuronState_v_n_a_s sN;
-    NeuronState_v_n_a_s dxdtinout;
-    myArrayDouble4 sA;
+    cout.precision(4);                              // Adjust precision to cout
+    std::cout.setf( std::ios::fixed, std:: ios::floatfield );
+    sweep.run();
+    cout << "=========================================" << endl;
+    sweep.printReport(cout);
+    if (SAVE_SIMULATION)
+        sweep.writeFile(fileNameStr+"_Sweep.txt", description);
+}
 
-    vector<NeuronState_v_n_a_s> outputAct;
-    runge_kutta4< NeuronState_v_n_a_s > stepper;        // Solver/stepper from ODEint library
+int main(int argc, char* argv[]) {
 
     if (parseParameters(argc, argv)<0)
         exit(0);
@@ -362,180 +459,52 @@ int main(int argc, char* argv[]) {
     // ============================
     directory_existsCreate(outputDir);
 
-    // Initial conditions applied current for every neuron
-    // The same distribution for all simulations
-    // =========================================
-    initRandIappValues(iapp);
-    
-    nExcNeurons = (int) nNeurons*pExcNeurons;       // amount of excitatory neurons
-    nInhNeurons = nNeurons-nExcNeurons;             // amount of inhibitory neurons
+    // Network, applied currents and initial conditions for every neuron
+    // =================================================================
+    if (!sweepParam.values.empty()) {               // The sweep starts with its first value
+        if (sweepParam.variable == SweepVariable::PExcN)
+            param.pExcNeurons = sweepParam.values[0];
+        else
+            param.vInh = sweepParam.values[0];
+    }
+    Simulation sim(param);
+    const unsigned int nNeurons = param.nNeurons;
+    const unsigned int nInhNeurons = sim.nInhNeurons();
+    const double dt = param.dt;
+    const double maxTimeSimulation = param.maxTimeSimulation;
+    const double vInh = param.vInh;
 
     // Simulation
     // ==================================
     cout << "Simulation ...!!!" << endl;
-    showParameters();
-
-    // Initial conditions for every neuron
-    // ===================================
-    initEachNeuron();
-    activePhase = false;
-    t=0.0; 
-    burstCount = 0;
-
-    te = clock();                                   // To get the simulation time
-    cout.precision(4);                              // Adjust precision to cout
-    std::cout.setf( std::ios::fixed, std:: ios::floatfield );
-        
-    while (burstCount<maxNumBurst and t<=maxTimeSimulation) {
-
-        // Total synaptic drive exc/inh for all cells
-        atotExc = atotInh = 0.0;
-
-        // Synaptic drive from excitatory cells
-        // atotexc=sum(0,100)of(shift(s0,i')*shift(a0,i'))/100
-        // remembering the order: v, n, a, s -> 0, 1, 2, 3
-        for ( n = 0; n < nExcNeurons; n++) {
-            atotExc += network[n][3]*network[n][2];
-        }
-        // Synaptic drive from inhibitory cells
-        for ( n = nExcNeurons; n < nNeurons; n++) {
-            atotInh += network[n][3]*network[n][2];
-        }
-
-        // Saving the previous state of the network to detecting episodes
-        sN_1[0] = sN_1[1] = sN_1[2] = sN_1[3] = 0.0;
-        for (n = 0; n < nNeurons; n++) {
-            sN_1[0] +=network[n][0];
-            sN_1[1] +=network[n][1];
-            sN_1[2] +=network[n][2];
-            sN_1[3] +=network[n][3];
-        }
-        sN_1[0] = sN_1[0]/nNeurons;
-        sN_1[1] = sN_1[1]/nNeurons;
-        sN_1[2] = sN_1[2]/nNeurons;
-        sN_1[3] = sN_1[3]/nNeurons;
-
-        // Initialize the Network state
-        sN[0] = sN[1] = sN[2] = sN[3] = 0.0;
-        
-        // For each neuron
-        for ( n = 0; n < nNeurons; n++) {
-            // Synaptic drive exc/inh
-            atotExcj = atotExc; atotInhj = atotInh;
-            // Taking out the contribution of the own cell i
-            iappj = iapp[n];                                // Get the original distribution [-10 .. 5] iapp dist
-            if (n<nExcNeurons) { //excitatory
-                atotExcj -= network[n][3]*network[n][2];
-            } else { // inhibitory
-                atotInhj -= network[n][3]*network[n][2];    // remove its own synapse
-            }
+    showParameters(sim);
 
-            v_1 = network[n][0];                            // Save previous voltage, used to detect spikes
-            // Integration, solving the ODE
-            stepper.do_step( HH_NeuronModel,
-                        network[n],
-                        t,
-                        dt);
-
-            // Detecting spikes
-            // Detecting Depolarization
-            if (!depolarization[n] &&               // It is not already on Depolarization period
-                    network[n][0]>=Vthresh &&       // Voltage >= Vth
-                    (network[n][0]-v_1)/dt>0) {     // Positive slope
-                depolarization[n] = true;
-                s_t = t;                            // Saving time value
-            }
-            // Detecting Repolarization
-            if ( depolarization[n] &&               // It was on Depolarization period
-                    network[n][0]<=Vthresh &&       // Voltage <= Vth
-                    (network[n][0]-v_1)/dt<0) {     // Negative slope
-                depolarization[n] = false;
-                mSpikeTrain->addSpikeTimeToNeuron(n,t);
-            }
-
-            // Accumulating/Sum for each neuron state
-            sN[0] +=network[n][0];
-            sN[1] +=network[n][1];
-            sN[2] +=network[n][2];
-            sN[3] +=network[n][3];
-        }
-
-        // Normalize the current state of the network for V A N and S
-        sN[0] = sN[0]/nNeurons; 
-        sN[1] = sN[1]/nNeurons; 
-        sN[2] = sN[2]/nNeurons; 
-        sN[3] = sN[3]/nNeurons;
-        
-        // Population activity and synaptic recovery for excitatory neurons
-        actTotalExc=sTotalExc= 0;
-        for ( n = 0; n < nExcNeurons; n++) {
-            actTotalExc += network[n][2];
-            sTotalExc += network[n][3];
-        }
-
-        // Population activity and synaptic recovery for inhibitory neurons
-        actTotalInh=sTotalInh= 0;
-        for ( n = nExcNeurons; n < nNeurons; n++) {
-            actTotalInh += network[n][2];
-            sTotalInh += network[n][3];
-        }
-
-        // Detecting episode
-        sA[2] = 0.0;
-        if (!activePhase &&                         // It is not already on active phase
-                sN[2]>=thA &&                       // Activity > thA
-                (sN[2]-sN_1[2])/dt>thDA) {          // Activity derivative > thDA
-            activePhase = true;
-
-            // Save values of Aexc, Ainh, time episode, 1
-            sA[0] = actTotalExc/nExcNeurons;
-            sA[1] = actTotalInh/nInhNeurons;
-            sA[2] = t;
-            sA[3] = 1;
-            networkOutputs.push_back(sA);           // Aexc, Ainh, time episode, 1
-        } else if (activePhase &&                   // It was on active phase
-                sN[2]<thA) {                        // Activity < thA
-            activePhase = false;
-            ++burstCount;                           // Counting the episode
-            cout << "<" << nExcNeurons << "," << vInh << ">" << "- burst:" << burstCount << ", time: "<< t << endl;
-
-            // Save values of Aexc, Ainh, time episode, 1
-            sA[0] = actTotalExc/nExcNeurons;
-            sA[1] = actTotalInh/nInhNeurons;
-            sA[2] = -t;
-            sA[3] = 1;
-            networkOutputs.push_back(sA);           // Aexc, Ainh, -time episode, 1
-        }
-
-        // Saving the current state of the network
-        ave.push_back(sN);
-        
-        // increment time
-        t+= dt;
+    if (!sweepParam.values.empty()) {
+        runSweep(sim);
+        return 0;
     }
 
-    te = clock()-te;
-    cout << "Simulation duration: " << ((float)te)/CLOCKS_PER_SEC <<" seconds"<< endl;
-    cout << "=========================================" << endl;
-
+    // Output files, written while the simulation runs
+    // ================================================
+    string fileNameStr, fileNameSpikesStr;
     if (SAVE_SIMULATION) {
-        string solver = "rk4_";
-        string sdt = "dt0" + to_string((int)(dt*10000)) + "_";
-        
-        string fileNameStr = outputDir + "/HH_BBT_" +
+        string solver = sim.solverName() + (pararealParam.nWindows > 0 ? "_parareal_" : "_");
+        string sdt = "dt0" + to_string(lround(dt*10000)) + "_";     // Rounded, -dt 0.03 is not 299
+
+        fileNameStr = outputDir + "/HH_BBT_" +
                 solver + sdt +
                 to_string(nNeurons) + "," +
                 to_string(nInhNeurons) + ",vI" +
                 to_string((int)vInh) + ",t=" +
                 to_string((int)(maxTimeSimulation/1000)) +"s_" +
                 actualPrecisionType;
-        writeToFile(fileNameStr+"_IappORIG.txt", ave);
-        
-        // Saving the Episodes start/end times
-        writeToFile( fileNameStr+"_IappORIG,Epis.txt", networkOutputs);
 
-        // Saving the applied currents values
-        writeIappToFile(fileNameStr+"_IappORIG,Iapp.txt", iapp, n_precision);
+        // The window run stops at traceTo, its files must not replace the
+        // ones of the full run
+        string window;
+        if (traceTo >= 0)
+            window = "_window" + to_string(traceFrom) + "-" + to_string(traceTo);
+        fileNameStr += window;
 
         string _underscore = "_";
         string negPosVInh;
@@ -543,23 +512,149 @@ int main(int argc, char* argv[]) {
             negPosVInh = _underscore + to_string((int)abs(vInh)) + "_t";
         else
             negPosVInh = to_string((int)abs(vInh)) + "_t";
-        
-        // Saving spike train in Matlab format
-        fileNameStr = outputDir + "/HH_BBT_" +
+
+        // Spike train in Matlab format
+        fileNameSpikesStr = outputDir + "/HH_BBT_" +
                 solver + sdt +
                 to_string(nNeurons) + "_" +
                 to_string(nInhNeurons) + "_vI_" +
                 negPosVInh +
                 to_string((int)(maxTimeSimulation/1000)) + "s_" +
-                actualPrecisionType;
-        mSpikeTrain->printToMatlabFile(fileNameStr+"_IappORIG_Spikes.m", n_precision);
+                actualPrecisionType + window;
+
+        mResultWriter = new ResultWriter(fileNameStr+"_IappORIG.txt",           // Average of V N A and S
+                                        fileNameStr+"_IappORIG,Epis.txt",       // Episodes start/end times
+                                        fileNameSpikesStr+"_IappORIG_Spikes.m", // Spike times
+                                        nNeurons, n_precision, writerChunkSize);
+
+        string description = "HH_BBT " + solver + sdt + to_string(nNeurons) + "," +
+                to_string(nInhNeurons) + ",vI" + to_string((int)vInh);
+        if (fingerprintEvery > 0)
+            mFingerprint = new Fingerprint(fileNameStr+"_IappORIG,Fingerprint.txt",   // Step, time, hash, spikes
+                                            fingerprintEvery, description);
+
+        if (lyapunovExponents > 0)
+            mLyapunov = new Lyapunov(sim, lyapunovExponents, lyapunovRenorm,
+                                    fileNameStr+"_IappORIG,Lyapunov.txt",      // Step, time, local l1, l1 .. lk
+                                    fileNameStr+"_IappORIG,LyapEpis.txt",      // Start, end, duration, l1 episode/silent phase
+                                    description);
+
+        if (traceTo >= 0) {
+            cout << "Writing in file: "<< fileNameStr+"_IappORIG,Window.txt" << endl;
+            windowFile.open(fileNameStr+"_IappORIG,Window.txt");                     // Step, neuron, v n a s
+            windowFile.precision(numeric_limits<actualDoubleP>::max_digits10);      // Exact values
+            windowFile.setf( std::ios::scientific, std::ios::floatfield );
+            windowFile << "# " << description << ", steps " << traceFrom << " .. " << traceTo << "\n"
+                        << "# step\tneuron\tv\tn\ta\ts\n";
+        }
+    }
+
+    // Observers of the simulation
+    // ===========================
+    if (mResultWriter) {
+        sim.addSpikeObserver([](const Simulation &/*sim*/, ConstSpan<SpikeEvent> spikes) {
+            for (const SpikeEvent &sp : spikes)
+                mResultWriter->addSpikeTimeToNeuron(sp.neuron, sp.t);
+        });
+        sim.addEpisodeObserver([](const Simulation &/*sim*/, ConstSpan<myEpisodeDouble4> episodes) {
+            for (const myEpisodeDouble4 &sA : episodes)
+                mResultWriter->addEpisode(sA);          // Aexc, Ainh, +/-time episode, 1
+        });
+        sim.addStepObserver([](const Simulation &/*sim*/, ConstSpan<NeuronState_v_n_a_s> /*network*/,
+                                const myArrayDouble4 &sN) {
+            mResultWriter->addTraceRow(sN);             // Saving the current state of the network
+        });
+    }
+    if (mFingerprint) {
+        sim.addSpikeObserver([](const Simulation &/*sim*/, ConstSpan<SpikeEvent> spikes) {
+            mFingerprint->addSpikes(spikes.size());
+        });
+        sim.addStepObserver([](const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network,
+                                const myArrayDouble4 &/*sN*/) {
+            mFingerprint->addStep(sim, network);
+        });
+    }
+    if (mLyapunov) {
+        sim.addEpisodeObserver([](const Simulation &/*sim*/, ConstSpan<myEpisodeDouble4> episodes) {
+            for (const myEpisodeDouble4 &sA : episodes)
+                mLyapunov->addEpisode(sA);
+        });
+        sim.addStepObserver([](const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network,
+                                const myArrayDouble4 &/*sN*/) {
+            mLyapunov->addStep(sim, network);
+        });
+    }
+    if (windowFile.is_open()) {
+        sim.addStepObserver([](const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network,
+                                const myArrayDouble4 &/*sN*/) {
+            long k = sim.stepCount();
+            if (k < traceFrom || k > traceTo)
+                return;
+            for (size_t n = 0; n < network.size(); n++)
+                windowFile << k << "\t" << n << "\t" << network[n][0] << "\t" << network[n][1]
+                            << "\t" << network[n][2] << "\t" << network[n][3] << "\n";
+        });
+    }
+    sim.addEpisodeObserver([](const Simulation &sim, ConstSpan<myEpisodeDouble4> episodes) {
+        for (const myEpisodeDouble4 &sA : episodes)
+            if (sA[2] < 0)                              // End of the episode
+                cout << "<" << sim.nExcNeurons() << "," << sim.parameters().vInh << ">" << "- burst:" << sim.burstCount() << ", time: "<< sim.time() << endl;
+    });
+
+    te = clock();                                   // To get the simulation time
+    cout.precision(4);                              // Adjust precision to cout
+    std::cout.setf( std::ios::fixed, std:: ios::floatfield );
+
+    if (pararealParam.nWindows > 0) {
+        Parareal parareal(param, pararealParam);
+        const unsigned int nExcNeurons = sim.nExcNeurons();
+        if (mResultWriter) {
+            parareal.onSpike([](const SpikeEvent &sp) {
+                mResultWriter->addSpikeTimeToNeuron(sp.neuron, sp.t);
+            });
+            parareal.onTrace([](const myArrayDouble4 &sN) {
+                mResultWriter->addTraceRow(sN);
+            });
+        }
+        parareal.onEpisode([nExcNeurons](const myEpisodeDouble4 &sA, unsigned int nBurst) {
+            if (mResultWriter)
+                mResultWriter->addEpisode(sA);          // Aexc, Ainh, +/-time episode, 1
+            if (sA[2] < 0)                              // End of the episode
+                cout << "<" << nExcNeurons << "," << param.vInh << ">" << "- burst:" << nBurst << ", time: "<< -sA[2] << endl;
+        });
+        parareal.run();
+        parareal.printReport(cout);
+        if (pararealCheck)
+            parareal.compareWithSerial(cout);
+    } else if (traceTo >= 0)                        // No need to go beyond the window
+        sim.runUntil(min(maxTimeSimulation, (traceTo+0.5)*dt));
+    else
+        sim.run();
+
+    te = clock()-te;
+    cout << "Simulation duration: " << ((float)te)/CLOCKS_PER_SEC <<" seconds"<< endl;
+    cout << "=========================================" << endl;
+    if (mLyapunov)
+        mLyapunov->printSummary(cout);
+
+    if (SAVE_SIMULATION) {
+        // Flushing the trace, episodes and spike times still buffered
+        mResultWriter->close();
+        if (mFingerprint)
+            mFingerprint->close();
+        if (mLyapunov)
+            mLyapunov->close();
+        if (windowFile.is_open())
+            windowFile.close();
+
+        // Saving the applied currents values
+        writeIappToFile(fileNameStr+"_IappORIG,Iapp.txt", sim.iappValues(), n_precision);
     }
 
     // Releasing the memory
-    iapp.clear();
-    networkOutputs.clear();
-    ave.clear();
-    delete mSpikeTrain;
+    delete mResultWriter;
+    delete mFingerprint;
+    delete mLyapunov;
 
     return 0;
 }
@@ -0,0 +1,367 @@
+//============================================================================
+// Name        : Lyapunov.cpp
+// Created on  : Oct, 2026
+// Author      :
+// Description :
+//   Module to estimate the leading Lyapunov exponents of the network with
+//   the variational (tangent linear) equations, see Lyapunov_allP.h.
+//   The tangent vectors follow the discrete step of the simulation: RK4 of
+//   each neuron with the synaptic drive frozen during the step, so the
+//   perturbation of the drive of neuron j is
+//      dAexc_j = sum_{m exc, m != j} (s_m*da_m + a_m*ds_m)
+//   taken at the start of the step (the same for the inhibitory drive).
+//   It is computed in double precision for any precision of the model: the
+//   exponents are a property of the system, not of the rounding.
+// Used by     : HH_BBT2017_allP.cpp
+//============================================================================
+
+#include "Lyapunov_allP.h"
+
+#include <iostream>     // std::cout
+#include <iomanip>      // std::setprecision
+#include <cmath>        // exp, expm1, log, sqrt
+#include <random>       // std::mt19937_64
+#include <limits>
+
+#include <boost/multiprecision/cpp_dec_float.hpp>
+
+using namespace std;
+
+typedef boost::array<double,4> StateD;
+
+// Rounding errors of each precision, for the divergence horizons
+static const struct {
+    const char *name;
+    double eps;
+} precisionEps[nPrecisionEps] = {
+    {"float", numeric_limits<float>::epsilon()},
+    {"double", numeric_limits<double>::epsilon()},
+    {"long double", numeric_limits<long double>::epsilon()},
+    {"boost double", static_cast<double>(numeric_limits<boost::multiprecision::cpp_dec_float_100>::epsilon())}
+};
+
+// Constants of HHModel_allP.h in double
+static const double gl_d = static_cast<double>(gl), vl_d = static_cast<double>(vl);
+static const double gnabar_d = static_cast<double>(gnabar), vna_d = static_cast<double>(vna), h0_d = static_cast<double>(h0);
+static const double gkbar_d = static_cast<double>(gkbar), vk_d = static_cast<double>(vk);
+static const double taus_d = static_cast<double>(taus), tauf_d = static_cast<double>(tauf);
+static const double alphad_d = static_cast<double>(alphad), betad_d = static_cast<double>(betad);
+static const double Vthresh_d = static_cast<double>(Vthresh), kv_d = static_cast<double>(kv);
+
+// Non zero entries of the Jacobian of a neuron, d(v n a s)'/d(v n a s),
+// and of dv'/dAexc, dv'/dAinh
+struct NeuronJacobian {
+    double vv, vn, vExc, vInh;
+    double nv, nn;
+    double av, aa;
+    double sv, ss;
+};
+
+// g(x) = x/(exp(x)-1) and g'(x), series near the removable singularity x = 0
+static inline void xOverExpm1(const double x, double &g, double &dg) {
+    if (abs(x) < 1e-4) {
+        g = 1 - x/2 + x*x/12;
+        dg = -0.5 + x/6;
+        return;
+    }
+    double em1 = expm1(x);
+    g = x/em1;
+    dg = (em1 - x*(em1+1))/(em1*em1);
+}
+
+// Right hand side of the neuron model and its Jacobian at y, with the
+// synaptic drives ae and ai (own synapse taken out)
+static inline void neuronJacobian(const StateD &y, const double iappj, const double ae, const double ai,
+                                    const double gsyn, const double vExc, const double vInh,
+                                    StateD &f, NeuronJacobian &J) {
+    const double v = y[0], n = y[1], a = y[2], s = y[3];
+    double g1, dg1, g2, dg2;
+
+    // am = .1*(25-v)/(exp(.1*(25-v))-1), an = .01*(10-v)/(exp(.1*(10-v))-1)
+    xOverExpm1(.1*(25-v), g1, dg1);
+    xOverExpm1(.1*(10-v), g2, dg2);
+    const double am = g1, dam = -.1*dg1;
+    const double an = .1*g2, dan = -.01*dg2;
+    const double bm = 4.0*exp(-v/18), dbm = -bm/18;
+    const double bn = .125*exp(-v/80), dbn = -bn/80;
+    const double fs = 1/(1+exp((Vthresh_d-v)/kv_d)), dfs = fs*(1-fs)/kv_d;
+
+    const double minf = am/(am+bm);
+    const double dminf = (dam*bm - am*dbm)/((am+bm)*(am+bm));
+    const double m3 = minf*minf*minf;
+    const double n3 = n*n*n;
+
+    f[0] = -gl_d*(v-vl_d) - gnabar_d*m3*(h0_d-n)*(v-vna_d) - gkbar_d*n3*n*(v-vk_d)
+            - gsyn*ae*(v-vExc) - gsyn*ai*(v-vInh) + iappj;
+    J.vv = -gl_d - gnabar_d*(3*minf*minf*dminf*(h0_d-n)*(v-vna_d) + m3*(h0_d-n))
+            - gkbar_d*n3*n - gsyn*ae - gsyn*ai;
+    J.vn = gnabar_d*m3*(v-vna_d) - 4*gkbar_d*n3*(v-vk_d);
+    J.vExc = -gsyn*(v-vExc);
+    J.vInh = -gsyn*(v-vInh);
+
+    f[1] = an-(an+bn)*n;
+    J.nv = dan-(dan+dbn)*n;
+    J.nn = -(an+bn);
+
+    f[2] = fs*(1-a)/tauf_d - a/taus_d;
+    J.av = dfs*(1-a)/tauf_d;
+    J.aa = -fs/tauf_d - 1/taus_d;
+
+    f[3] = alphad_d*(1-s) - betad_d*fs*s;
+    J.sv = -betad_d*dfs*s;
+    J.ss = -alphad_d - betad_d*fs;
+}
+
+// dk = J*d + perturbation of the drives
+static inline void applyJacobian(const NeuronJacobian &J, const double *d, const double dae, const double dai,
+                                    double *dk) {
+    dk[0] = J.vv*d[0] + J.vn*d[1] + J.vExc*dae + J.vInh*dai;
+    dk[1] = J.nv*d[0] + J.nn*d[1];
+    dk[2] = J.av*d[0] + J.aa*d[2];
+    dk[3] = J.sv*d[0] + J.ss*d[3];
+}
+
+Lyapunov::Lyapunov(const Simulation &sim, unsigned int nExp, unsigned long renorm,
+                    string const fileName, string const episodeFileName, string const description) {
+
+    const SimulationParameters &p = sim.parameters();
+    if (nExp<=0 || nExp>4*p.nNeurons || renorm<=0) {
+        cerr << "Lyapunov <constructor> parameter wrong!! Values should be integer > 0 (exponents <= 4*neurons)" << endl;
+        exit(-1);
+    }
+    if (p.solver != Solver::RK4) {
+        cerr << "Lyapunov <constructor> the tangent vectors follow the RK4 step, solver " << sim.solverName() << " not available" << endl;
+        exit(-1);
+    }
+
+    this->nExp = nExp;
+    this->renorm = renorm;
+    nNeurons = p.nNeurons;
+    nExc = sim.nExcNeurons();
+    dt = p.dt;
+    gsyn = gsynTotal/nNeurons;
+    vExc = p.vExc;
+    vInh = p.vInh;
+    for (const actualDoubleP &i : sim.iappValues())
+        iapp.push_back(static_cast<double>(i));
+
+    x0.resize(nNeurons);
+    ConstSpan<NeuronState_v_n_a_s> network = sim.state();
+    for (unsigned int n = 0; n < nNeurons; n++)
+        for (int i = 0; i < 4; i++)
+            x0[n][i] = static_cast<double>(network[n][i]);
+
+    // Random orthonormal tangent vectors, the same for every run
+    mt19937_64 gen(2017);
+    normal_distribution<double> normal;
+    q.assign(nExp, vector<double>(4*nNeurons));
+    for (vector<double> &qi : q)
+        for (double &x : qi)
+            x = normal(gen);
+    logSum.assign(nExp, 0.0);
+    t0 = tRenorm = static_cast<double>(sim.time());
+    steps = 0;
+    orthonormalize(t0);
+    logSum.assign(nExp, 0.0);                           // The initial norms do not count
+    for (int i = 0; i < nPrecisionEps; i++)
+        reached[i] = -1;
+
+    episodeStart = silentStart = t0;
+    episodeLogSum = silentLogSum = 0.0;
+
+    cout << "Writing in file: "<< fileName << endl;
+    file.open(fileName);
+    if (!file.is_open())
+        cout << "Unable to open file: "<< fileName << endl;
+    file << "# " << description << "\n"
+            << "# precision " << actualPrecisionType << ", " << nExp << " exponents, orthonormalized every " << renorm << " steps\n"
+            << "# step\ttime\tlocal l1\tl1";
+    for (unsigned int i = 1; i < nExp; i++)
+        file << "\tl" << i+1;
+    file << "\t(1/ms)\n";
+    file.precision(8);
+
+    cout << "Writing in file: "<< episodeFileName << endl;
+    episodeFile.open(episodeFileName);
+    if (!episodeFile.is_open())
+        cout << "Unable to open file: "<< episodeFileName << endl;
+    episodeFile << "# " << description << "\n"
+            << "# start\tend\tduration\tl1 episode\tl1 silent phase before (1/ms)\n";
+    episodeFile.precision(8);
+}
+
+Lyapunov::~Lyapunov() {
+    close();
+}
+
+// One step of the tangent vectors from the state x0, as the RK4 step of
+// the simulation (stages 0, dt/2, dt/2, dt)
+void Lyapunov::tangentStep() {
+    vector<double> dAexc(nExp, 0.0), dAinh(nExp, 0.0);
+    double atotExc = 0, atotInh = 0;
+
+    // Synaptic drives and their perturbations at the start of the step
+    for (unsigned int n = 0; n < nNeurons; n++) {
+        const StateD &x = x0[n];
+        if (n<nExc)
+            atotExc += x[3]*x[2];
+        else
+            atotInh += x[3]*x[2];
+        for (unsigned int k = 0; k < nExp; k++) {
+            const double *d = &q[k][4*n];
+            if (n<nExc)
+                dAexc[k] += x[3]*d[2] + x[2]*d[3];
+            else
+                dAinh[k] += x[3]*d[2] + x[2]*d[3];
+        }
+    }
+
+    StateD y, f[4];
+    NeuronJacobian J[4];
+    double d[4], dk[4][4];
+    for (unsigned int n = 0; n < nNeurons; n++) {
+        const StateD &x = x0[n];
+        const double own = x[3]*x[2];
+        const double ae = n<nExc ? atotExc-own : atotExc;
+        const double ai = n<nExc ? atotInh : atotInh-own;
+
+        // Stages of the trajectory and the Jacobians there
+        const double c[4] = {0, dt/2, dt/2, dt};
+        for (int st = 0; st < 4; st++) {
+            for (int i = 0; i < 4; i++)
+                y[i] = st == 0 ? x[i] : x[i] + c[st]*f[st-1][i];
+            neuronJacobian(y, iapp[n], ae, ai, gsyn, vExc, vInh, f[st], J[st]);
+        }
+
+        // The same stages for every tangent vector
+        for (unsigned int k = 0; k < nExp; k++) {
+            double *d0 = &q[k][4*n];
+            double dae = dAexc[k], dai = dAinh[k];
+            if (n<nExc)
+                dae -= x[3]*d0[2] + x[2]*d0[3];             // Own synapse out
+            else
+                dai -= x[3]*d0[2] + x[2]*d0[3];
+            for (int st = 0; st < 4; st++) {
+                for (int i = 0; i < 4; i++)
+                    d[i] = st == 0 ? d0[i] : d0[i] + c[st]*dk[st-1][i];
+                applyJacobian(J[st], d, dae, dai, dk[st]);
+            }
+            for (int i = 0; i < 4; i++)
+                d0[i] += dt/6*(dk[0][i] + 2*dk[1][i] + 2*dk[2][i] + dk[3][i]);
+        }
+    }
+}
+
+// Modified Gram-Schmidt, the logarithms of the norms are the growths
+void Lyapunov::orthonormalize(double t) {
+    double local = 0;
+    for (unsigned int i = 0; i < nExp; i++) {
+        vector<double> &qi = q[i];
+        for (unsigned int j = 0; j < i; j++) {
+            double dot = 0;
+            for (size_t m = 0; m < qi.size(); m++)
+                dot += qi[m]*q[j][m];
+            for (size_t m = 0; m < qi.size(); m++)
+                qi[m] -= dot*q[j][m];
+        }
+        double norm = 0;
+        for (double x : qi)
+            norm += x*x;
+        norm = sqrt(norm);
+        for (double &x : qi)
+            x /= norm;
+        logSum[i] += log(norm);
+        if (i == 0)
+            local = log(norm);
+    }
+
+    if (t > tRenorm && file.is_open()) {
+        file << steps-1 << "\t" << fixed << setprecision(2) << t << "\t" << scientific << setprecision(8)
+                << local/(t-tRenorm);
+        for (unsigned int i = 0; i < nExp; i++)
+            file << "\t" << logSum[i]/(t-t0);
+        file << "\n";
+    }
+    for (int i = 0; i < nPrecisionEps; i++)
+        if (reached[i] < 0 && logSum[0] >= log(1/precisionEps[i].eps))
+            reached[i] = t;
+    tRenorm = t;
+}
+
+// Called after each step, the state of the network at sim.time()+dt
+void Lyapunov::addStep(const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network) {
+    tangentStep();
+    for (unsigned int n = 0; n < nNeurons; n++)
+        for (int i = 0; i < 4; i++)
+            x0[n][i] = static_cast<double>(network[n][i]);
+
+    if (++steps % renorm == 0)
+        orthonormalize(static_cast<double>(sim.time())+dt);
+}
+
+// Called with the episodes of a step, before addStep: the tangent vectors
+// are at sim.time(), the time of the episode
+void Lyapunov::addEpisode(const myEpisodeDouble4 &sA) {
+    double t = abs(static_cast<double>(sA[2]));
+    double norm = 0;
+    for (double x : q[0])
+        norm += x*x;
+    double logGrowth = logSum[0] + log(sqrt(norm));         // Since t0, also between orthonormalizations
+
+    if (sA[2] > 0) {                                        // Start of the episode
+        episodeStart = t;
+        episodeLogSum = logGrowth;
+    } else {                                                // End of the episode
+        episodeFile << fixed << setprecision(2) << episodeStart << "\t" << t << "\t" << t-episodeStart << "\t"
+                << scientific << setprecision(8)
+                << (t > episodeStart ? (logGrowth-episodeLogSum)/(t-episodeStart) : 0.0) << "\t"
+                << (episodeStart > silentStart ? (episodeLogSum-silentLogSum)/(episodeStart-silentStart) : 0.0) << "\n";
+        silentStart = t;
+        silentLogSum = logGrowth;
+    }
+}
+
+vector<double> Lyapunov::exponents() const {
+    vector<double> l(nExp, 0.0);
+    if (tRenorm > t0)
+        for (unsigned int i = 0; i < nExp; i++)
+            l[i] = logSum[i]/(tRenorm-t0);
+    return l;
+}
+
+void Lyapunov::printSummary(ostream &out) const {
+    vector<double> l = exponents();
+    ios_base::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+
+    out << "Lyapunov exponents (1/ms), t = " << t0 << " .. " << tRenorm << " ms:";
+    for (unsigned int i = 0; i < nExp; i++)
+        out << " l" << i+1 << " = " << scientific << setprecision(4) << l[i];
+    out << fixed << "\n";
+
+    // The growth is not uniform (fast in the transient and the silent
+    // phases), the time where it reaches 1/eps is given too
+    out << "Divergence horizon: ln(1/eps)/l1, and time where the growth of a perturbation reaches 1/eps\n";
+    for (int i = 0; i < nPrecisionEps; i++) {
+        out << "  " << precisionEps[i].name << " (eps " << scientific << setprecision(2) << precisionEps[i].eps << "): "
+                << fixed << setprecision(1);
+        if (l[0] > 0)
+            out << log(1/precisionEps[i].eps)/l[0] << " ms, ";
+        else
+            out << "l1 <= 0, ";
+        if (reached[i] >= 0)
+            out << reached[i] << " ms\n";
+        else
+            out << "not reached\n";
+    }
+    out << flush;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void Lyapunov::close() {
+    if (file.is_open())
+        file.close();
+    if (episodeFile.is_open())
+        episodeFile.close();
+}
@@ -0,0 +1,67 @@
+#ifndef LYAPUNOV_H_
+#define LYAPUNOV_H_
+
+#include <vector>
+#include <string>               // std::string, std::to_string
+#include <fstream>              // std::ofstream
+#include <ostream>
+
+#include "checkActualPrecision.h"
+#include "Simulation_allP.h"
+
+using namespace std;
+
+// Leading Lyapunov exponents of the network, estimated while it runs.
+// k tangent vectors (perturbations of v, n, a, s of every neuron) are
+// integrated with the variational equations of the neuron model and of the
+// coupling, linearized along the trajectory of the simulation, and they are
+// orthonormalized (modified Gram-Schmidt) every m steps. The logarithms of
+// the norms give the exponents (1/ms). The tangent step linearizes the RK4
+// step, so only the RK4 solver is supported.
+// With the largest exponent l1 a perturbation of the size of the rounding
+// error eps of a precision reaches 1 after ln(1/eps)/l1 ms: the horizon
+// after which runs with different roundings diverge.
+
+const int nPrecisionEps = 4;                // float, double, long double, Boost
+
+class Lyapunov {
+    unsigned int nExp;                      // Exponents, k
+    unsigned long renorm;                   // Steps between orthonormalizations, m
+    unsigned int nNeurons, nExc;
+    double dt, gsyn, vExc, vInh;
+    vector<double> iapp;
+
+    vector< boost::array<double,4> > x0;    // State at the start of the step
+    vector< vector<double> > q;             // Tangent vectors, 4*nNeurons values
+
+    vector<double> logSum;                  // Sum of the logarithms of the growths
+    double t0, tRenorm;                     // Start of the estimation, last orthonormalization
+    double reached[nPrecisionEps];          // Time where the growth reached 1/eps, -1: not yet
+    unsigned long steps;
+
+    // Episodes: log growth of the tangent vector 1 at the start/end
+    double episodeStart, episodeLogSum, silentStart, silentLogSum;
+
+    ofstream file, episodeFile;
+
+    void tangentStep();
+    void orthonormalize(double t);
+
+public:
+    Lyapunov(const Simulation &sim, unsigned int nExp, unsigned long renorm,
+                string const fileName, string const episodeFileName, string const description);
+    virtual ~Lyapunov();
+
+    void addStep(const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network);
+    void addEpisode(const myEpisodeDouble4 &sA);
+
+    // Exponents estimated since the start, 1/ms
+    vector<double> exponents() const;
+
+    // Exponents and divergence horizon of each precision
+    void printSummary(ostream &out) const;
+
+    void close();
+};
+
+#endif /* LYAPUNOV_H_ */
@@ -0,0 +1,417 @@
+//============================================================================
+// Name        : Parareal.cpp
+// Created on  : Oct, 2026
+// Author      :
+// Description :
+//   Parareal time-parallel integration of the network (experimental), see
+//   Parareal_allP.h. The fine and coarse propagators are Simulation objects
+//   (one per window) moved to the boundary states with setState().
+// Used by     : HH_BBT2017_allP.cpp
+//============================================================================
+
+#include "Parareal_allP.h"
+
+#include <iostream>     // std::cout
+#include <cmath>        // abs
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>    // std::min, std::max
+#include <limits>       // std::numeric_limits
+
+using namespace std;
+
+static double elapsed(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+}
+
+static ConstSpan<NeuronState_v_n_a_s> span(const vector<NeuronState_v_n_a_s> &x) {
+    return ConstSpan<NeuronState_v_n_a_s>(x.data(), x.size());
+}
+
+// Bit by bit equality (not ==, that would take 0 and -0 as equal and NaN
+// as different from itself)
+static bool sameState(const vector<NeuronState_v_n_a_s> &a, const vector<NeuronState_v_n_a_s> &b) {
+    for (size_t n = 0; n < a.size(); n++)
+        for (int i = 0; i < 4; i++) {
+            if (isnan(a[n][i]) && isnan(b[n][i]))
+                continue;
+            if (!(a[n][i] == b[n][i]) || signbit(a[n][i]) != signbit(b[n][i]))
+                return false;
+        }
+    return true;
+}
+
+// Infinity if any difference is not finite (std::max would skip a NaN)
+static double maxDifference(const vector<NeuronState_v_n_a_s> &a, const vector<NeuronState_v_n_a_s> &b) {
+    double d = 0;
+    for (size_t n = 0; n < a.size(); n++)
+        for (int i = 0; i < 4; i++) {
+            actualDoubleP x = a[n][i]-b[n][i];
+            if (!isfinite(x))
+                return numeric_limits<double>::infinity();
+            d = max(d, (double) abs(x));
+        }
+    return d;
+}
+
+static bool isFiniteState(const vector<NeuronState_v_n_a_s> &x) {
+    for (size_t n = 0; n < x.size(); n++)
+        for (int i = 0; i < 4; i++)
+            if (!isfinite(x[n][i]))
+                return false;
+    return true;
+}
+
+Parareal::Parareal(const SimulationParameters &p, const PararealParameters &pp) :
+        param(p), pp(pp) {
+
+    if (pp.nWindows<=0 || pp.coarseFactor<=0) {
+        cerr << "Parareal <constructor> parameter wrong!! Values should be integer > 0" << endl;
+        exit(-1);
+    }
+    nThreads = pp.nThreads ? pp.nThreads : max(1u, thread::hardware_concurrency());
+    seconds = 0;
+    replayedSteps = 0;
+    nSpikes = 0;
+
+    setupWindows();
+}
+
+Parareal::~Parareal() {
+}
+
+// Windows of the same amount of steps, with the times of the serial run
+void Parareal::setupWindows() {
+    const double dt = param.dt;
+    long double t = 0.0;
+
+    // Steps of the serial run: while t <= maxTimeSimulation
+    totalSteps = 0;
+    while (t <= param.maxTimeSimulation) {
+        t += dt;
+        totalSteps++;
+    }
+    unsigned int nWindows = min((unsigned long) pp.nWindows, totalSteps);
+    unsigned long stepsPerWindow = (totalSteps+nWindows-1)/nWindows;
+    nWindows = (totalSteps+stepsPerWindow-1)/stepsPerWindow;
+
+    windowStart.resize(nWindows+1);
+    windowTime.resize(nWindows+1);
+    t = 0.0;
+    for (unsigned long k = 0, n = 0; k <= totalSteps; k++) {
+        if (k == n*stepsPerWindow || k == totalSteps) {
+            windowStart[n] = k;
+            windowTime[n] = t;
+            if (++n > nWindows)
+                break;
+        }
+        t += dt;
+    }
+
+    SimulationParameters pf = param;
+    pf.keepSpikeTrain = false;
+    fine.assign(nWindows, Simulation(pf));
+    records.resize(nWindows);
+    for (unsigned int n = 0; n < nWindows; n++) {
+        // Coarse propagator: the same time with a dt coarseFactor times larger
+        unsigned long steps = windowStart[n+1]-windowStart[n];
+        coarseSteps.push_back(max(1UL, (steps+pp.coarseFactor/2)/pp.coarseFactor));
+        SimulationParameters pc = pf;
+        pc.dt = steps*dt/coarseSteps[n];
+        coarse.push_back(Simulation(pc));
+
+        // The fine solve records what the serial replay needs
+        WindowRecord &r = records[n];
+        r.average.reserve(steps);
+        r.aExc.reserve(steps);
+        r.aInh.reserve(steps);
+        fine[n].addStepObserver([&r, dt](const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network,
+                                const myArrayDouble4 &average) {
+            const unsigned long k = sim.stepCount();
+            const unsigned int nExc = sim.nExcNeurons();
+            accumDoubleP actTotalExc = 0;
+            accumDoubleP actTotalInh = 0;
+
+            for (unsigned int i = 0; i < network.size(); i++) {
+                const actualDoubleP &v = network[i][0];
+                // Same conditions as Simulation::advance(). A neuron can only be
+                // depolarized if it was over Vthresh at the start or rose over it
+                if (v>=Vthresh && (v-r.vPrev[i])/dt>0) {
+                    r.crossings.push_back({k, i, true});
+                    r.maybeDepolarized[i] = true;
+                } else if (r.maybeDepolarized[i] && v<=Vthresh && (v-r.vPrev[i])/dt<0) {
+                    r.crossings.push_back({k, i, false});
+                    r.maybeDepolarized[i] = false;
+                }
+                r.vPrev[i] = v;
+
+                if (i<nExc)
+                    actTotalExc += toAccumP(network[i][2]);
+                else
+                    actTotalInh += toAccumP(network[i][2]);
+            }
+            r.average.push_back(average);
+            r.aExc.push_back(actTotalExc/nExc);
+            r.aInh.push_back(actTotalInh/sim.nInhNeurons());
+        });
+    }
+
+    U.assign(nWindows+1, vector<NeuronState_v_n_a_s>(param.nNeurons));
+    F.assign(nWindows, vector<NeuronState_v_n_a_s>(param.nNeurons));
+    G.assign(nWindows, vector<NeuronState_v_n_a_s>(param.nNeurons));
+    fineDone.assign(nWindows, false);
+}
+
+void Parareal::solveFine(unsigned int n) {
+    WindowRecord &r = records[n];
+    r.average.clear();
+    r.aExc.clear();
+    r.aInh.clear();
+    r.crossings.clear();
+    r.vPrev.resize(param.nNeurons);
+    r.maybeDepolarized.resize(param.nNeurons);
+    for (unsigned int i = 0; i < param.nNeurons; i++) {
+        r.vPrev[i] = U[n][i][0];
+        r.maybeDepolarized[i] = U[n][i][0]>=Vthresh;
+    }
+
+    fine[n].setState(span(U[n]), windowTime[n], windowStart[n]);
+    fine[n].step(windowStart[n+1]-windowStart[n]);
+    ConstSpan<NeuronState_v_n_a_s> x = fine[n].state();
+    F[n].assign(x.begin(), x.end());
+}
+
+void Parareal::solveCoarse(unsigned int n, vector<NeuronState_v_n_a_s> &out) {
+    Simulation &c = coarse[n];
+    c.setState(span(U[n]), windowTime[n], windowStart[n]);
+    c.step(coarseSteps[n]);
+    ConstSpan<NeuronState_v_n_a_s> x = c.state();
+    out.assign(x.begin(), x.end());
+}
+
+// Fine solves of the given windows, nThreads at a time
+void Parareal::parallelFine(const vector<unsigned int> &windows) {
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < windows.size(); i = next++)
+            solveFine(windows[i]);
+    };
+    vector<thread> threads;
+    unsigned int nt = min((size_t) nThreads, windows.size());
+    for (unsigned int i = 1; i < nt; i++)
+        threads.push_back(thread(worker));
+    worker();
+    for (thread &th : threads)
+        th.join();
+    for (unsigned int n : windows)              // vector<bool>: not from the threads
+        fineDone[n] = true;
+}
+
+unsigned long Parareal::run() {
+    const unsigned int nWindows = fine.size();
+    const unsigned int maxIterations = pp.maxIterations ? min(pp.maxIterations, nWindows) : nWindows;
+    vector<NeuronState_v_n_a_s> Unew(param.nNeurons), Gnew(param.nNeurons);
+    vector<bool> changed(nWindows+1, false);
+    auto t0 = chrono::steady_clock::now();
+
+    report.clear();
+    fineDone.assign(nWindows, false);
+
+    // Initial conditions and prediction with the coarse propagator
+    Simulation initial(param);
+    U[0].assign(initial.state().begin(), initial.state().end());
+    for (unsigned int n = 0; n < nWindows; n++) {
+        solveCoarse(n, G[n]);
+        U[n+1] = G[n];
+    }
+
+    for (unsigned int k = 0; k < maxIterations; k++) {
+        auto ti = chrono::steady_clock::now();
+        PararealIteration it = {k+1, 0, 0, 0, 0};
+
+        // Fine solves of the windows whose start changed, in parallel.
+        // The windows before k are exact and already solved
+        vector<unsigned int> windows;
+        for (unsigned int n = k; n < nWindows; n++)
+            if (!fineDone[n])
+                windows.push_back(n);
+        parallelFine(windows);
+        it.fineSolves = windows.size();
+
+        // Serial correction: U[n+1] = F(U[n]) + (G_new(U[n]) - G_old(U[n]))
+        fill(changed.begin(), changed.end(), false);
+        for (unsigned int n = k; n < nWindows; n++) {
+            if (changed[n]) {
+                solveCoarse(n, Gnew);
+                for (unsigned int i = 0; i < param.nNeurons; i++)
+                    for (int j = 0; j < 4; j++)
+                        Unew[i][j] = F[n][i][j] + (Gnew[i][j] - G[n][i][j]);
+                G[n] = Gnew;
+                // With a large coarse dt RK4 can overflow from some states,
+                // then the fine result is the better guess
+                if (!isFiniteState(Unew))
+                    Unew = F[n];
+            } else
+                Unew = F[n];                        // Same start: exactly the fine result
+            if (!sameState(Unew, U[n+1])) {
+                it.maxChange = max(it.maxChange, maxDifference(Unew, U[n+1]));
+                it.changedWindows++;
+                changed[n+1] = true;
+                U[n+1] = Unew;
+                if (n+1 < nWindows)
+                    fineDone[n+1] = false;
+            }
+        }
+        it.seconds = elapsed(ti);
+        report.push_back(it);
+
+        if (it.changedWindows == 0 || it.maxChange <= pp.tol)
+            break;
+    }
+
+    // Fine solves from the final boundaries, then the serial replay
+    vector<unsigned int> windows;
+    for (unsigned int n = 0; n < nWindows; n++)
+        if (!fineDone[n])
+            windows.push_back(n);
+    parallelFine(windows);
+
+    unsigned long steps = replay();
+    seconds = elapsed(t0);
+    return steps;
+}
+
+// Serial spike and episode detection from the records of the fine solves,
+// in the same order as Simulation::advance() and its observers
+unsigned long Parareal::replay() {
+    const double dt = param.dt;
+    const unsigned int nWindows = fine.size();
+    vector<bool> depolarization(param.nNeurons, false);
+    bool activePhase = false;
+    unsigned int nBurst = 0;
+    myArrayDouble4 sN, sN_1;
+    myEpisodeDouble4 sA;
+
+    Simulation initial(param);
+    sN = initial.average();
+    nSpikes = 0;
+    episodes.clear();
+
+    for (unsigned int n = 0; n < nWindows; n++) {
+        const WindowRecord &r = records[n];
+        long double t = windowTime[n];
+        size_t c = 0;
+
+        for (unsigned long j = 0; j < r.average.size(); j++) {
+            const unsigned long k = windowStart[n]+j;
+            if (nBurst>=param.maxNumBurst)
+                return replayedSteps = k;
+
+            // Spikes
+            for (; c < r.crossings.size() && r.crossings[c].step == k; c++) {
+                const Crossing &x = r.crossings[c];
+                if (x.up) {
+                    if (!depolarization[x.neuron])
+                        depolarization[x.neuron] = true;
+                } else if (depolarization[x.neuron]) {
+                    depolarization[x.neuron] = false;
+                    nSpikes++;
+                    if (spikeCallback)
+                        spikeCallback({x.neuron, (double) t});
+                }
+            }
+
+            // Episodes
+            sN_1 = sN;
+            sN = r.average[j];
+            bool episode = false;
+            if (!activePhase &&
+                    sN[2]>=thA &&
+                    (sN[2]-sN_1[2])/dt>thDA) {
+                activePhase = true;
+                sA[2] = t;
+                episode = true;
+            } else if (activePhase &&
+                    sN[2]<thA) {
+                activePhase = false;
+                ++nBurst;
+                sA[2] = -t;
+                episode = true;
+            }
+            if (episode) {
+                sA[0] = r.aExc[j];
+                sA[1] = r.aInh[j];
+                sA[3] = 1;
+                episodes.push_back(sA);
+                if (episodeCallback)
+                    episodeCallback(sA, nBurst);
+            }
+
+            if (traceCallback)
+                traceCallback(sN);
+            t += dt;
+        }
+    }
+    return replayedSteps = totalSteps;
+}
+
+void Parareal::printReport(ostream &out) const {
+    out << "Parareal: " << fine.size() << " windows of " << windowStart[1]-windowStart[0]
+            << " steps, coarse dt = " << pp.coarseFactor << "*dt, " << nThreads << " threads, tol = " << pp.tol << "\n";
+    out << "iteration\tmax |change|\tchanged windows\tfine solves\tseconds\n";
+    for (const PararealIteration &it : report)
+        out << it.k << "\t\t" << it.maxChange << "\t\t" << it.changedWindows << "\t\t"
+                << it.fineSolves << "\t\t" << it.seconds << "\n";
+    out << "Wall time: " << seconds << " s, " << replayedSteps << " of " << totalSteps << " integrated steps, "
+            << nSpikes << " spikes, " << episodes.size() << " episode starts/ends" << endl;
+}
+
+void Parareal::compareWithSerial(ostream &out) {
+    const unsigned int nWindows = fine.size();
+    vector< vector<NeuronState_v_n_a_s> > boundary(nWindows+1);
+    vector<myEpisodeDouble4> serialEpisodes;
+    unsigned long serialSpikes = 0;
+
+    Simulation serial(param);
+    boundary[0].assign(serial.state().begin(), serial.state().end());
+    serial.addStepObserver([&](const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network,
+                            const myArrayDouble4 &/*average*/) {
+        for (unsigned int n = 1; n <= nWindows; n++)
+            if (sim.stepCount()+1 == windowStart[n])
+                boundary[n].assign(network.begin(), network.end());
+    });
+    serial.addSpikeObserver([&](const Simulation &/*sim*/, ConstSpan<SpikeEvent> spikes) {
+        serialSpikes += spikes.size();
+    });
+    serial.addEpisodeObserver([&](const Simulation &/*sim*/, ConstSpan<myEpisodeDouble4> e) {
+        serialEpisodes.insert(serialEpisodes.end(), e.begin(), e.end());
+    });
+    auto t0 = chrono::steady_clock::now();
+    serial.run();
+    double serialSeconds = elapsed(t0);
+
+    double maxDiff = 0;
+    unsigned int exact = 0, compared = 0;
+    for (unsigned int n = 1; n <= nWindows; n++) {
+        if (boundary[n].empty())                    // The serial run stopped before (maxNumBurst)
+            break;
+        compared++;
+        maxDiff = max(maxDiff, maxDifference(boundary[n], U[n]));
+        if (sameState(boundary[n], U[n]))
+            exact++;
+    }
+    double maxEpisodeDiff = 0;
+    size_t nEpisodes = min(serialEpisodes.size(), episodes.size());
+    for (size_t i = 0; i < nEpisodes; i++)
+        maxEpisodeDiff = max(maxEpisodeDiff, (double) abs(abs(serialEpisodes[i][2])-abs(episodes[i][2])));
+
+    out << "Comparison with the serial run:\n"
+            << "Window boundaries: " << exact << "/" << compared << " bit by bit equal, max |difference| " << maxDiff << "\n"
+            << "Steps: serial " << serial.stepCount() << ", parareal " << replayedSteps << "\n"
+            << "Spikes: serial " << serialSpikes << ", parareal " << nSpikes << "\n"
+            << "Episode starts/ends: serial " << serialEpisodes.size() << ", parareal " << episodes.size()
+            << ", max |time difference| " << maxEpisodeDiff << " ms\n"
+            << "Wall time: serial " << serialSeconds << " s, parareal " << seconds << " s, speedup "
+            << serialSeconds/seconds << endl;
+}
@@ -0,0 +1,121 @@
+#ifndef PARAREAL_H_
+#define PARAREAL_H_
+
+// Parareal time-parallel integration of the network (experimental).
+// The simulation time is split in windows. A coarse propagator G (RK4 with
+// coarseFactor*dt) predicts the state at the window boundaries and the fine
+// propagator F (the normal step, dt) integrates all the windows in parallel.
+// Each iteration corrects the boundaries serially:
+//      U[n+1] = F(U[n]) + (G_new(U[n]) - G_old(U[n]))
+// After k iterations the first k windows are exact (bit by bit the serial
+// result); with tol = 0 the result is the serial one.
+//
+// Spikes and episodes depend on the detection state carried from one step
+// to the next one, so the fine solves record the raw threshold crossings and
+// the averages per step, and they are replayed serially at the end.
+//
+// The windows always cover the whole maxTimeSimulation: the step where
+// maxNumBurst is reached is only known after the replay, so with a small
+// maxNumBurst the fine solves integrate steps that the replay discards.
+
+#include <vector>
+#include <string>       // std::string, std::to_string
+#include <functional>   // std::function
+#include <ostream>
+
+#include "checkActualPrecision.h"
+#include "HHModel_allP.h"
+#include "Simulation_allP.h"
+
+using namespace std;
+
+struct PararealParameters {
+    unsigned int nWindows = 32;                 // Time windows
+    unsigned int coarseFactor = 10;             // Coarse dt = coarseFactor*dt
+    unsigned int nThreads = 0;                  // Threads for the fine solves, 0: all the cores
+    unsigned int maxIterations = 0;             // 0: nWindows (exact result)
+    double tol = 1e-6;                          // Max |boundary change| between iterations to stop
+};
+
+struct PararealIteration {
+    unsigned int k;
+    double maxChange;                           // Max |boundary change| of any variable
+    unsigned int changedWindows;                // Boundaries that changed at all
+    unsigned int fineSolves;
+    double seconds;                             // Wall time of the iteration
+};
+
+class Parareal {
+public:
+    typedef function<void(const SpikeEvent &spike)> SpikeCallback;
+    typedef function<void(const myEpisodeDouble4 &episode, unsigned int nBurst)> EpisodeCallback;
+    typedef function<void(const myArrayDouble4 &average)> TraceCallback;
+
+    Parareal(const SimulationParameters &p, const PararealParameters &pp);
+    virtual ~Parareal();
+
+    void onSpike(SpikeCallback cb) { spikeCallback = cb; }
+    void onEpisode(EpisodeCallback cb) { episodeCallback = cb; }
+    void onTrace(TraceCallback cb) { traceCallback = cb; }
+
+    // Results until maxTimeSimulation or maxNumBurst, as Simulation::run()
+    // (the integration always goes until maxTimeSimulation)
+    unsigned long run();
+
+    const vector<PararealIteration> &iterations() const { return report; }
+    double wallTime() const { return seconds; }
+
+    // Runs the serial simulation and compares it with the last run()
+    void compareWithSerial(ostream &out);
+    void printReport(ostream &out) const;
+
+private:
+    // Raw threshold crossing of a neuron in a step
+    struct Crossing {
+        unsigned long step;
+        unsigned int neuron;
+        bool up;                                // true: v >= Vthresh rising, false: v <= Vthresh falling
+    };
+
+    // What the fine solve of a window records for the serial replay
+    struct WindowRecord {
+        vector<myArrayDouble4> average;         // Per step
+        vector<accumDoubleP> aExc, aInh;        // Per step, mean activity exc/inh
+        vector<Crossing> crossings;
+        vector<actualDoubleP> vPrev;
+        vector<bool> maybeDepolarized;
+    };
+
+    SimulationParameters param;
+    PararealParameters pp;
+    unsigned int nThreads;
+
+    unsigned long totalSteps;
+    vector<unsigned long> windowStart;          // nWindows+1 steps
+    vector<long double> windowTime;             // t at windowStart, accumulated as the serial run
+    vector<unsigned long> coarseSteps;          // Steps of the coarse propagator per window
+
+    vector<Simulation> fine, coarse;
+    vector<WindowRecord> records;
+    vector< vector<NeuronState_v_n_a_s> > U;    // Boundary states
+    vector< vector<NeuronState_v_n_a_s> > F, G; // Fine/coarse results of each window
+    vector<bool> fineDone;                      // F/records of window n are from the actual U[n]
+
+    vector<PararealIteration> report;
+    double seconds;
+    unsigned long replayedSteps;
+    unsigned long nSpikes;
+    vector<myEpisodeDouble4> episodes;
+
+    SpikeCallback spikeCallback;
+    EpisodeCallback episodeCallback;
+    TraceCallback traceCallback;
+
+    void setupWindows();
+    void solveFine(unsigned int n);
+    void solveCoarse(unsigned int n, vector<NeuronState_v_n_a_s> &out);
+    void parallelFine(const vector<unsigned int> &windows);
+    unsigned long replay();
+};
+
+#endif /* PARAREAL_H_ */
@@ -0,0 +1,198 @@
+//============================================================================
+// Name        : ResultWriter.cpp
+// Created on  : Oct, 2026
+// Author      :
+// Description :
+//   Module to stream the simulation results (average trace, episodes and
+//   spike times) to disk from a separate thread using two fixed-size
+//   buffers, so the memory used does not grow with the simulation time.
+//   The files have the same layout as writeToFile() and
+//   SpikeTrain::printToMatlabFile().
+// Used by     : HH_BBT2017_allP.cpp
+//============================================================================
+
+#include "ResultWriter_allP.h"
+
+#include <iostream>     // std::cout
+#include <cstdio>       // std::remove
+
+using namespace std;
+
+ResultWriter::ResultWriter(string const traceFileName, string const episFileName, string const spikesFileName,
+        const unsigned int n, int n_p, size_t chunkSize) {
+
+    if (n<=0 || chunkSize<=0) {
+        cerr << "ResultWriter <constructor> parameter wrong!! Values should be integer > 0" << endl;
+        exit(-1);
+    }
+
+    this->nNeurons = n;
+    this->chunkSize = chunkSize;
+    this->spikesFileName = spikesFileName;
+    this->spikesTmpFileName = spikesFileName + ".tmp";
+
+    cout << "Writing in file: "<< traceFileName << endl;
+    traceFile.open(traceFileName);
+    if (!traceFile.is_open())
+        cout << "Unable to open file: "<< traceFileName << endl;
+    traceFile.precision(n_p);                           // Adjust precision
+    traceFile.setf( std::ios::fixed, std::ios::floatfield );
+
+    cout << "Writing in file: "<< episFileName << endl;
+    episFile.open(episFileName);
+    if (!episFile.is_open())
+        cout << "Unable to open file: "<< episFileName << endl;
+    episFile.precision(n_p);                            // Adjust precision
+    episFile.setf( std::ios::fixed, std::ios::floatfield );
+
+    spikesTmpFile.open(spikesTmpFileName, ios::in | ios::out | ios::trunc | ios::binary);
+    if (!spikesTmpFile.is_open())
+        cerr << "Unable to open file: "<< spikesTmpFileName << endl;
+
+    for (int i = 0; i < 2; i++) {
+        chunks[i].trace.reserve(chunkSize);
+        chunks[i].episodes.reserve(chunkSize);
+        chunks[i].spikes.reserve(chunkSize);
+    }
+    front = &chunks[0];
+    back = &chunks[1];
+    backPending = false;
+    stopping = false;
+    closed = false;
+
+    writerThread = thread(&ResultWriter::writerLoop, this);
+}
+
+ResultWriter::~ResultWriter() {
+    close();
+}
+
+void ResultWriter::addTraceRow(const ResultRow &row) {
+    front->trace.push_back(row);
+    checkChunkFull();
+}
+
+void ResultWriter::addEpisode(const EpisodeRow &row) {
+    front->episodes.push_back(row);
+    checkChunkFull();
+}
+
+void ResultWriter::addSpikeTimeToNeuron(const unsigned int n, const double t) {
+
+    if (n>=nNeurons) {
+        cerr << "ResultWriter <addSpikeTimeToNeuron> Neuron index out of range!!\n No spike added" << endl;
+        return;
+    }
+    front->spikes.push_back({n, t});
+    checkChunkFull();
+}
+
+void ResultWriter::checkChunkFull() {
+    if (front->trace.size() >= chunkSize ||
+            front->episodes.size() >= chunkSize ||
+            front->spikes.size() >= chunkSize)
+        swapChunks();
+}
+
+// Hand the front chunk to the writer thread, waiting only if it is
+// still busy with the previous one
+void ResultWriter::swapChunks() {
+    unique_lock<mutex> lock(mtx);
+    cv.wait(lock, [this]{ return !backPending; });
+    swap(front, back);
+    backPending = true;
+    lock.unlock();
+    cv.notify_all();
+}
+
+void ResultWriter::writerLoop() {
+    unique_lock<mutex> lock(mtx);
+    while (true) {
+        cv.wait(lock, [this]{ return backPending || stopping; });
+        if (backPending) {
+            lock.unlock();
+            writeChunk(*back);              // The simulation does not touch the back chunk
+            lock.lock();
+            backPending = false;
+            cv.notify_all();
+        } else if (stopping)
+            return;
+    }
+}
+
+void ResultWriter::writeChunk(Chunk &c) {
+
+    for (unsigned int i=0; i<c.trace.size(); i++) {
+        traceFile << c.trace[i][0] << '\t' << c.trace[i][1] << '\t' << c.trace[i][2] << '\t' << c.trace[i][3] << '\n';
+    }
+    for (unsigned int i=0; i<c.episodes.size(); i++) {
+        episFile << c.episodes[i][0] << '\t' << c.episodes[i][1] << '\t' << c.episodes[i][2] << '\t' << c.episodes[i][3] << '\n';
+    }
+    if (c.spikes.size() > 0)
+        spikesTmpFile.write(reinterpret_cast<const char*>(c.spikes.data()), c.spikes.size()*sizeof(SpikeEvent));
+
+    c.trace.clear();
+    c.episodes.clear();
+    c.spikes.clear();
+}
+
+// Flush the pending rows, stop the writer thread and build the Matlab spike file
+void ResultWriter::close() {
+
+    if (closed)
+        return;
+    closed = true;
+
+    swapChunks();                           // Remaining rows of the front chunk
+    {
+        lock_guard<mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    writerThread.join();
+
+    traceFile.close();
+    episFile.close();
+
+    writeSpikesFile();
+    spikesTmpFile.close();
+    remove(spikesTmpFileName.c_str());
+}
+
+// The Matlab file lists the spike times neuron by neuron: the temporary
+// file is read once, with a chunk-sized buffer, and the times are grouped
+// per neuron (a few values per neuron and burst, small next to the trace)
+void ResultWriter::writeSpikesFile() {
+
+    ofstream myfile(spikesFileName);
+
+    cout << "Writing in file: "<< spikesFileName << endl;
+
+    if (!myfile.is_open()) {
+        cerr << "Unable to open file: "<< spikesFileName << endl;
+        return;
+    }
+
+    vector<SpikeEvent> &buffer = chunks[0].spikes;
+    buffer.resize(chunkSize);
+    vector<vector<double>> spikeTimes(nNeurons);
+
+    spikesTmpFile.flush();
+    spikesTmpFile.clear();
+    spikesTmpFile.seekg(0, ios::beg);
+    while (spikesTmpFile.read(reinterpret_cast<char*>(buffer.data()), chunkSize*sizeof(SpikeEvent)) ||
+            spikesTmpFile.gcount() > 0) {
+        size_t nRead = spikesTmpFile.gcount()/sizeof(SpikeEvent);
+        for (size_t i = 0; i < nRead; i++)
+            spikeTimes[buffer[i].neuron].push_back(buffer[i].t);
+    }
+    buffer.clear();
+
+    for (unsigned int neuronI = 0; neuronI < nNeurons; ++neuronI) {
+        myfile << "spikeTimes{"<< to_string(neuronI+1)<<  "} = [";
+        for (double t : spikeTimes[neuronI])
+            myfile << " " << to_string(t);
+        myfile << "];"<<'\n';
+    }
+    myfile.close();
+}
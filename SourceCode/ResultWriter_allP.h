@@ -0,0 +1,73 @@
+#ifndef RESULTWRITER_H_
+#define RESULTWRITER_H_
+
+#include <vector>
+#include <string>               // std::string, std::to_string
+#include <fstream>              // std::ofstream, std::fstream
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <boost/array.hpp>
+
+#include "checkActualPrecision.h"
+
+using namespace std;
+
+typedef boost::array<accumDoubleP, 4> ResultRow;      // Same layout as myArrayDouble4
+typedef boost::array<episodeDoubleP, 4> EpisodeRow;   // Same layout as myEpisodeDouble4
+
+// Streams the simulation results to disk from its own thread.
+// The simulation fills the front chunk while the writer thread drains the
+// back one; when the front chunk is full both are swapped, so the memory
+// used is bounded by 2 chunks whatever the simulation length.
+class ResultWriter {
+    struct SpikeEvent {
+        unsigned int neuron;
+        double t;
+    };
+    struct Chunk {
+        vector<ResultRow> trace;            // Average of V N A and S per step
+        vector<EpisodeRow> episodes;        // Aexc, Ainh, +/-time episode, 1
+        vector<SpikeEvent> spikes;          // Spike times in arrival order
+    };
+
+    unsigned int nNeurons;
+    size_t chunkSize;
+    string spikesFileName;
+    string spikesTmpFileName;
+
+    ofstream traceFile;
+    ofstream episFile;
+    fstream spikesTmpFile;                  // Spike events, neuron-grouped at close()
+
+    Chunk chunks[2];
+    Chunk *front;                           // Filled by the simulation
+    Chunk *back;                            // Drained by the writer thread
+    bool backPending;
+    bool stopping;
+    bool closed;
+
+    mutex mtx;
+    condition_variable cv;
+    thread writerThread;
+
+    void swapChunks();
+    void checkChunkFull();
+    void writerLoop();
+    void writeChunk(Chunk &c);
+    void writeSpikesFile();
+
+public:
+    ResultWriter(string const traceFileName, string const episFileName, string const spikesFileName,
+            const unsigned int n, int n_p, size_t chunkSize);
+    virtual ~ResultWriter();
+
+    void addTraceRow(const ResultRow &row);
+    void addEpisode(const EpisodeRow &row);
+    void addSpikeTimeToNeuron(const unsigned int n, const double t);
+
+    void close();
+};
+
+#endif /* RESULTWRITER_H_ */
@@ -0,0 +1,507 @@
+//============================================================================
+// Name        : Simulation.cpp
+// Created on  : Oct, 2026
+// Author      :
+// Description :
+//   Simulation of the network, library version of the loop previously in
+//   HH_BBT2017_allP.cpp:
+//   network of 100 HH (reduced) cells with heterogeneous input current (Ii)
+//   all to all coupling with synaptic depression
+//   From Tabak, Mascagni, Bertram. J Neurophysiol, 103:2208-2221, 2010.
+//
+//   New version:
+//   - some % are inhibitory neurons
+//
+//   From Blanco, Tabak, Bertram. J Frontiers in Comp. Neuroscience, 2017.
+//============================================================================
+
+#include "Simulation_allP.h"
+
+#include <iostream>     // std::cout
+#include <limits>
+
+#include <boost/numeric/odeint.hpp>
+
+#include "iappDist_allP.h"
+
+using namespace std;
+
+using namespace boost::numeric::odeint;
+
+// Value type of the RK4 coefficients. The single precision modes integrate
+// with float coefficients and dt, the other ones keep the double coefficients
+#if defined(useFloatP) || defined(useMixedP)
+    typedef float stepperValueP;
+#else
+    typedef double stepperValueP;
+#endif
+
+#ifdef useBoostDoubleP
+// RK4 of ODEint written out for the Boost precision, same operations in the
+// same order (same results). ODEint multiplies by its double coefficients
+// (1.0, a[i]*dt, b[i]*dt) in every operation, converting them to the Boost
+// type; here they are converted once, and the stages and the temporaries
+// are kept in the stepper, reused by all the neurons and steps
+class BoostRK4Stepper {
+    actualDoubleP dt2, dt1, dt6, dt3;       // dt/2, dt, dt/6, dt/3, computed in double as in ODEint
+    NeuronState_v_n_a_s k1, k2, k3, k4, xt;
+    actualDoubleP tmp;
+
+    // xt = x + c*k
+    void stage(const NeuronState_v_n_a_s &x, const NeuronState_v_n_a_s &k, const actualDoubleP &c) {
+        for (int i = 0; i < 4; i++) {
+            xt[i] = x[i];
+            tmp = k[i];
+            tmp *= c;
+            xt[i] += tmp;
+        }
+    }
+
+    // x += c*k
+    void add(NeuronState_v_n_a_s &x, const NeuronState_v_n_a_s &k, const actualDoubleP &c) {
+        for (int i = 0; i < 4; i++) {
+            tmp = k[i];
+            tmp *= c;
+            x[i] += tmp;
+        }
+    }
+
+public:
+    BoostRK4Stepper(const double dt) :
+        dt2(dt/2), dt1(1.0*dt), dt6((1.0/6)*dt), dt3((1.0/3)*dt) {}
+
+    template <class System>
+    void do_step(System system, NeuronState_v_n_a_s &x, const long double t, const double dt) {
+        system(x, k1, t);
+        stage(x, k1, dt2);
+        system(xt, k2, t + dt/2);
+        stage(x, k2, dt2);
+        system(xt, k3, t + dt/2);
+        stage(x, k3, dt1);
+        system(xt, k4, t + dt);
+
+        add(x, k1, dt6);
+        add(x, k2, dt3);
+        add(x, k3, dt3);
+        add(x, k4, dt6);
+    }
+};
+#endif
+
+Simulation::Simulation(const SimulationParameters &p) :
+        param(p),
+        iapp(p.nNeurons),
+        network(p.nNeurons),
+        depolarization(p.nNeurons),
+        mSpikeTrain(p.nNeurons) {
+
+    if (param.nNeurons != nIappValues) {
+        cerr << "Simulation: " << param.nNeurons << " neurons, the applied current distribution is given for "
+                << nIappValues << " neurons" << endl;
+        exit(-1);
+    }
+
+    nExc = (int) param.nNeurons*param.pExcNeurons;      // amount of excitatory neurons
+    nInh = param.nNeurons-nExc;                         // amount of inhibitory neurons
+    gsyn = (double) (gsynTotal/param.nNeurons);
+    vExc = param.vExc;
+    vInh = param.vInh;
+
+    // Initial conditions applied current for every neuron
+    // The same distribution for all simulations
+    initRandIappValues(iapp);
+
+    iappj = atotExcj = atotInhj = 0.0;
+    init();
+}
+
+Simulation::~Simulation() {
+}
+
+void Simulation::init() {
+    unsigned int n;
+
+    // Initial conditions
+    // init v[0..99]=0 n[j]=0 a[j]=0.01 s[j]=.25
+    for (n = 0; n < param.nNeurons; n++) {
+        network[n][0]= 0.0;         // v
+        network[n][1]= 0.0;         // n
+        network[n][2]= 0.01;        // a
+        network[n][3]= 0.25;        // s
+        depolarization[n]=false;    // no spike found
+    }
+    activePhase = false;
+    t = 0.0;
+    nStep = 0;
+    nBurst = 0;
+
+    primeFromNetwork();
+}
+
+void Simulation::setState(ConstSpan<NeuronState_v_n_a_s> x, long double t, unsigned long nSteps) {
+    if (x.size() != param.nNeurons) {
+        cerr << "Simulation::setState: " << x.size() << " neurons, expected " << param.nNeurons << endl;
+        exit(-1);
+    }
+    for (unsigned int n = 0; n < param.nNeurons; n++) {
+        network[n] = x[n];
+        depolarization[n] = false;
+    }
+    activePhase = false;
+    this->t = t;
+    nStep = nSteps;
+    nBurst = 0;
+
+    primeFromNetwork();
+}
+
+void Simulation::setParameters(const SimulationParameters &p) {
+    if (p.nNeurons != param.nNeurons) {
+        cerr << "Simulation::setParameters: " << p.nNeurons << " neurons, expected " << param.nNeurons << endl;
+        exit(-1);
+    }
+    param = p;
+    nExc = (int) param.nNeurons*param.pExcNeurons;      // amount of excitatory neurons
+    nInh = param.nNeurons-nExc;                         // amount of inhibitory neurons
+    vExc = param.vExc;
+    vInh = param.vInh;
+    nBurst = 0;
+
+    primeFromNetwork();
+}
+
+// Synaptic drive and average state of the network. Afterwards both are
+// accumulated in the same pass that integrates each neuron (same order, so
+// the same values)
+void Simulation::primeFromNetwork() {
+    unsigned int n;
+
+    atotExc = atotInh = 0.0;
+    sN[0] = sN[1] = sN[2] = sN[3] = 0.0;
+    for ( n = 0; n < param.nNeurons; n++) {
+        if (n<nExc)
+            atotExc += toAccumP(network[n][3])*network[n][2];
+        else
+            atotInh += toAccumP(network[n][3])*network[n][2];
+        sN[0] +=toAccumP(network[n][0]);
+        sN[1] +=toAccumP(network[n][1]);
+        sN[2] +=toAccumP(network[n][2]);
+        sN[3] +=toAccumP(network[n][3]);
+    }
+    sN[0] = sN[0]/param.nNeurons;
+    sN[1] = sN[1]/param.nNeurons;
+    sN[2] = sN[2]/param.nNeurons;
+    sN[3] = sN[3]/param.nNeurons;
+}
+
+// dv/dt of a neuron, the rates r at x[0]
+// This function uses the constants of HHModel_allP.h and
+//  iappj;
+//  atotExcj, atotInhj;
+//  gsyn=3.6/nNeurons;
+template <class P>
+inline actualDoubleP Simulation::membraneDerivative(const NeuronState_v_n_a_s &x, const HHRates &r) const
+{
+    actualDoubleP vj = x[0];
+    actualDoubleP nj = x[1];
+
+    // Differential equations (XPP original version)
+    // v[i] membrane potential of cell i
+    // v[0..99]'= -gl*(v[j]-vl)
+    //              -gnabar*minf(v[j])^3*(h0-n[j])*(v[j]-vna)
+    //              -gkbar*n[j]^4*(v[j]-vk)
+    //              -gsyn*(atot-a[j]*s[j]/100)*(v[j]-vsyn)
+    //              +iapp([j])
+    if constexpr (P::hasInhNeurons)
+        return -gl*(vj-vl)
+                    -gnabar*powGate<3>(minf(r))*(h0-nj)*(vj-vna)
+                    -gkbar*powGate<4>(nj)*(vj-vk)
+                    -gsyn*atotExcj*(vj-vExc)
+                    -gsyn*atotInhj*(vj-vInh)
+                    +iappj;
+    else                                    // atotInhj = 0, no inhibitory synapses
+        return -gl*(vj-vl)
+                    -gnabar*powGate<3>(minf(r))*(h0-nj)*(vj-vna)
+                    -gkbar*powGate<4>(nj)*(vj-vk)
+                    -gsyn*atotExcj*(vj-vExc)
+                    +iappj;
+}
+
+// System ODEs per Neuron
+template <class P>
+void Simulation::neuronModel( const NeuronState_v_n_a_s &x , NeuronState_v_n_a_s &dxdt , long double /*t*/ ) const
+{
+    actualDoubleP vj = x[0];
+    actualDoubleP nj = x[1];
+    actualDoubleP aj = x[2];
+    actualDoubleP sj = x[3];
+    HHRates r;
+
+    hhRates<P>(vj, r);
+
+    dxdt[0] = membraneDerivative<P>(x, r);
+
+    // n[i] Activation of K+ conductance for cell i
+    // n[0..99]'= an(v[j])-(an(v[j])+bn(v[j]))*n[j]
+    dxdt[1] = r.an-(r.an+r.bn)*nj;
+
+    // a[i] Synaptic drive from cell i
+    // a[0..99]'= fsyn(v[j])*(1-a[j])/tauf - a[j]/taus
+#ifdef useBoostDoubleP
+    dxdt[2] = r.fsyn*(1-aj)*invTauf_c - aj*invTaus_c;
+#else
+    dxdt[2] = r.fsyn*(1-aj)/tauf - aj/taus;
+#endif
+
+    // s[i] Synaptic recovery for terminals from cell i
+    // s[0..99]'=alphad*(1-s[j])-betad*fsyn(v[j])*s[j]
+    dxdt[3] = alphad*(1-sj)-betad*r.fsyn*sj;
+}
+
+// Second order Rush-Larsen step (RL2, midpoint version). n, a and s are
+// updated with the exact solution for the rates frozen at the midpoint,
+// v with the explicit midpoint rule. 2 evaluations of the rates per step
+// (RK4: 4), and n, a and s stay stable for any dt; the step is limited by v
+template <class P>
+void Simulation::rushLarsenStep(NeuronState_v_n_a_s &x, const actualDoubleP &dt) const
+{
+    NeuronState_v_n_a_s xh;                 // State at t+dt/2
+    HHRates r;
+    GateRates g;
+    const actualDoubleP dt2 = dt/2;
+
+    // Half step with the rates at t
+    hhRates<P>(x[0], r);
+    hhGateRates(r, g);
+    xh[0] = x[0] + dt2*membraneDerivative<P>(x, r);
+    rushLarsenGates(x, g, dt2, xh);
+
+    // Full step with the rates at t+dt/2
+    hhRates<P>(xh[0], r);
+    hhGateRates(r, g);
+    const actualDoubleP dv = membraneDerivative<P>(xh, r);
+    rushLarsenGates(x, g, dt, x);
+    x[0] += dt*dv;
+}
+
+// Simulation steps for the parameter set P and the solver S, at most
+// maxSteps, while t <= tEnd and, if stopAtMaxBurst, burst count < maxNumBurst
+template <class P, Solver S>
+unsigned long Simulation::advance(unsigned long maxSteps, long double tEnd, bool stopAtMaxBurst) {
+
+    unsigned int n;
+    unsigned long k;
+    const unsigned int nNeurons = param.nNeurons;
+    const double dt = param.dt;
+    const actualDoubleP dtP = dt;               // dt of the RL2 step, in the precision of the model
+    accumDoubleP actTotalExc;
+    accumDoubleP actTotalInh;
+    actualDoubleP v_1;
+    accumDoubleP sTotalExc;
+    accumDoubleP sTotalInh;
+    accumDoubleP atotExcNext;
+    accumDoubleP atotInhNext;
+
+    myArrayDouble4 sN_1;
+    myEpisodeDouble4 sA;
+
+#ifdef useBoostDoubleP
+    BoostRK4Stepper stepper(dt);
+#else
+    runge_kutta4< NeuronState_v_n_a_s, stepperValueP > stepper;   // Solver/stepper from ODEint library
+#endif
+    NeuronSystem<P> system = {this};
+
+    for (k = 0; k < maxSteps; k++) {
+
+        if (t>tEnd || (stopAtMaxBurst && nBurst>=param.maxNumBurst))
+            break;
+
+        stepSpikes.clear();
+        stepEpisodes.clear();
+
+        // The previous state of the network, to detect episodes, is the
+        // average computed in the previous step
+        sN_1 = sN;
+
+        // Initialize the Network state, the synaptic drive for the next step
+        // and the population activity and synaptic recovery
+        sN[0] = sN[1] = sN[2] = sN[3] = 0.0;
+        atotExcNext = atotInhNext = 0.0;
+        actTotalExc = sTotalExc = 0;
+        actTotalInh = sTotalInh = 0;
+
+        // For each neuron, in a single pass
+        for ( n = 0; n < nNeurons; n++) {
+            // Synaptic drive exc/inh
+            // atotexc=sum(0,100)of(shift(s0,i')*shift(a0,i'))/100
+            // remembering the order: v, n, a, s -> 0, 1, 2, 3
+            // Taking out the contribution of the own cell i, in the precision
+            // of the reductions, then rounded to the precision of the model
+            iappj = iapp[n];                                // Get the original distribution [-10 .. 5] iapp dist
+            if (!P::hasInhNeurons || n<nExc) { //excitatory
+                atotExcj = atotExc - toAccumP(network[n][3])*network[n][2];
+                if constexpr (P::hasInhNeurons)
+                    atotInhj = atotInh;
+            } else { // inhibitory
+                atotExcj = atotExc;
+                atotInhj = atotInh - toAccumP(network[n][3])*network[n][2];    // remove its own synapse
+            }
+
+            v_1 = network[n][0];                            // Save previous voltage, used to detect spikes
+            // Integration, solving the ODE
+            if constexpr (S == Solver::RL2)
+                rushLarsenStep<P>(network[n], dtP);
+            else
+                stepper.do_step( system,
+                            network[n],
+                            t,
+                            dt);
+
+            // Detecting spikes
+            // Detecting Depolarization
+            if (!depolarization[n] &&               // It is not already on Depolarization period
+                    network[n][0]>=Vthresh &&       // Voltage >= Vth
+                    (network[n][0]-v_1)/dt>0) {     // Positive slope
+                depolarization[n] = true;
+            }
+            // Detecting Repolarization
+            if ( depolarization[n] &&               // It was on Depolarization period
+                    network[n][0]<=Vthresh &&       // Voltage <= Vth
+                    (network[n][0]-v_1)/dt<0) {     // Negative slope
+                depolarization[n] = false;
+                stepSpikes.push_back({n, (double) t});
+                if (param.keepSpikeTrain)
+                    mSpikeTrain.addSpikeTimeToNeuron(n,t);
+            }
+
+            // Accumulating/Sum for each neuron state
+            sN[0] +=toAccumP(network[n][0]);
+            sN[1] +=toAccumP(network[n][1]);
+            sN[2] +=toAccumP(network[n][2]);
+            sN[3] +=toAccumP(network[n][3]);
+
+            // Synaptic drive for the next step, population activity and
+            // synaptic recovery from the new state of the neuron
+            if (!P::hasInhNeurons || n<nExc) {
+                atotExcNext += toAccumP(network[n][3])*network[n][2];
+                actTotalExc += toAccumP(network[n][2]);
+                sTotalExc += toAccumP(network[n][3]);
+            } else {
+                atotInhNext += toAccumP(network[n][3])*network[n][2];
+                actTotalInh += toAccumP(network[n][2]);
+                sTotalInh += toAccumP(network[n][3]);
+            }
+        }
+        atotExc = atotExcNext;
+        atotInh = atotInhNext;
+
+        // Normalize the current state of the network for V A N and S
+        sN[0] = sN[0]/nNeurons;
+        sN[1] = sN[1]/nNeurons;
+        sN[2] = sN[2]/nNeurons;
+        sN[3] = sN[3]/nNeurons;
+
+        // Detecting episode
+        sA[2] = 0.0;
+        if (!activePhase &&                         // It is not already on active phase
+                sN[2]>=thA &&                       // Activity > thA
+                (sN[2]-sN_1[2])/dt>thDA) {          // Activity derivative > thDA
+            activePhase = true;
+
+            // Save values of Aexc, Ainh, time episode, 1
+            sA[0] = actTotalExc/nExc;
+            sA[1] = actTotalInh/nInh;
+            sA[2] = t;
+            sA[3] = 1;
+            stepEpisodes.push_back(sA);             // Aexc, Ainh, time episode, 1
+        } else if (activePhase &&                   // It was on active phase
+                sN[2]<thA) {                        // Activity < thA
+            activePhase = false;
+            ++nBurst;                               // Counting the episode
+
+            // Save values of Aexc, Ainh, time episode, 1
+            sA[0] = actTotalExc/nExc;
+            sA[1] = actTotalInh/nInh;
+            sA[2] = -t;
+            sA[3] = 1;
+            stepEpisodes.push_back(sA);             // Aexc, Ainh, -time episode, 1
+        }
+
+        notifyObservers();
+
+        // increment time
+        t+= dt;
+        nStep++;
+    }
+
+    return k;
+}
+
+// Dispatch to the step kernel specialized for the actual parameters and solver
+template <Solver S>
+unsigned long Simulation::dispatchKernel(unsigned long maxSteps, long double tEnd, bool stopAtMaxBurst) {
+    return selectKernel(nInh, [&](auto kernel) {
+        return advance<decltype(kernel), S>(maxSteps, tEnd, stopAtMaxBurst);
+    });
+}
+
+unsigned long Simulation::dispatch(unsigned long maxSteps, long double tEnd, bool stopAtMaxBurst) {
+    if (param.solver == Solver::RL2)
+        return dispatchKernel<Solver::RL2>(maxSteps, tEnd, stopAtMaxBurst);
+    else
+        return dispatchKernel<Solver::RK4>(maxSteps, tEnd, stopAtMaxBurst);
+}
+
+string Simulation::kernelName() const {
+    return selectKernel(nInh, [](auto kernel) {
+        return decltype(kernel)::name();
+    });
+}
+
+string Simulation::solverName() const {
+    return param.solver == Solver::RL2 ? "rl2" : "rk4";
+}
+
+void Simulation::notifyObservers() {
+    if (!stepSpikes.empty()) {
+        ConstSpan<SpikeEvent> spikes(stepSpikes.data(), stepSpikes.size());
+        for (auto &obs : spikeObservers)
+            obs(*this, spikes);
+    }
+    if (!stepEpisodes.empty()) {
+        ConstSpan<myEpisodeDouble4> episodes(stepEpisodes.data(), stepEpisodes.size());
+        for (auto &obs : episodeObservers)
+            obs(*this, episodes);
+    }
+    for (auto &obs : stepObservers)
+        obs(*this, state(), sN);
+}
+
+void Simulation::step(unsigned long nSteps) {
+    dispatch(nSteps, numeric_limits<long double>::infinity(), false);
+}
+
+unsigned long Simulation::runUntil(long double tEnd) {
+    return dispatch(numeric_limits<unsigned long>::max(), tEnd, true);
+}
+
+unsigned long Simulation::run() {
+    return runUntil(param.maxTimeSimulation);
+}
+
+bool Simulation::finished() const {
+    return nBurst>=param.maxNumBurst || t>param.maxTimeSimulation;
+}
+
+void Simulation::addStepObserver(StepObserver obs) {
+    stepObservers.push_back(obs);
+}
+
+void Simulation::addSpikeObserver(SpikeObserver obs) {
+    spikeObservers.push_back(obs);
+}
+
+void Simulation::addEpisodeObserver(EpisodeObserver obs) {
+    episodeObservers.push_back(obs);
+}
@@ -0,0 +1,173 @@
+#ifndef SIMULATION_H_
+#define SIMULATION_H_
+
+// Network of HH (reduced) cells with heterogeneous input current (Ii),
+// all to all coupling with synaptic depression and some % of inhibitory
+// neurons. From Blanco, Tabak, Bertram. J Frontiers in Comp. Neuroscience, 2017.
+//
+// Library interface (libhhbbt): a Simulation owns its network, spike train
+// and parameters, so several simulations can coexist in one process.
+// The library and its users must be compiled with the same precision flag
+// (see checkActualPrecision.h).
+
+#include <vector>
+#include <string>       // std::string, std::to_string
+#include <functional>   // std::function
+
+#include "checkActualPrecision.h"
+#include "HHModel_allP.h"
+#include "SpikeTrain_allP.h"
+
+using namespace std;
+
+// Read-only view of contiguous values owned by a Simulation. It is only
+// valid during the observer call that receives it
+template <class T>
+class ConstSpan {
+    const T *ptr;
+    size_t n;
+
+public:
+    ConstSpan(const T *ptr, size_t n) : ptr(ptr), n(n) {}
+
+    const T *data() const { return ptr; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    const T &operator[](size_t i) const { return ptr[i]; }
+    const T *begin() const { return ptr; }
+    const T *end() const { return ptr+n; }
+};
+
+struct SpikeEvent {
+    unsigned int neuron;
+    double t;                                   // Repolarization time: ms
+};
+
+// Integration method of each neuron
+enum class Solver {
+    RK4,                                        // Classical Runge-Kutta (ODEint runge_kutta4)
+    RL2                                         // Second order Rush-Larsen: exponential n, a, s; midpoint v
+};
+
+struct SimulationParameters {
+    unsigned int nNeurons = 100;                // Only 100: size of the applied current distribution
+    double dt = 0.01;                           // Time step: ms
+    double maxTimeSimulation = 8000;            // Maximum simulation time: ms
+    double pExcNeurons = 1;                     // Percentage of excitatory neurons
+    unsigned int maxNumBurst = 200;             // Amount of burst to be reached to stop the simulation
+    double vExc = 70.0;                         // Reversal potential of excitatory synapses
+    double vInh = -12.0;                        // Reversal potential of inhibitory synapses
+    bool keepSpikeTrain = false;                // Store the spike times in the owned SpikeTrain
+    Solver solver = Solver::RK4;
+};
+
+class Simulation {
+public:
+    // Observers are called after each step with views of the simulation data
+    typedef function<void(const Simulation &sim, ConstSpan<NeuronState_v_n_a_s> network,
+                            const myArrayDouble4 &average)> StepObserver;
+    typedef function<void(const Simulation &sim, ConstSpan<SpikeEvent> spikes)> SpikeObserver;
+    typedef function<void(const Simulation &sim, ConstSpan<myEpisodeDouble4> episodes)> EpisodeObserver;
+
+    Simulation(const SimulationParameters &p);
+    virtual ~Simulation();
+
+    void init();                                // Initial conditions, t = 0
+
+    // Continues from the network state x at time t after nSteps steps. The
+    // synaptic drive and the averages are computed from x; spike and episode
+    // detection restart (no neuron depolarized, no active phase, 0 bursts)
+    void setState(ConstSpan<NeuronState_v_n_a_s> x, long double t, unsigned long nSteps);
+
+    // Changes the parameters keeping the state of the network (continuation
+    // of a sweep), nNeurons must not change. The synaptic drive is computed
+    // again; the time and the spike and episode detection continue, the
+    // burst count restarts at 0 (maxNumBurst applies from here)
+    void setParameters(const SimulationParameters &p);
+
+    void step(unsigned long nSteps = 1);        // Exactly nSteps steps
+    unsigned long runUntil(long double tEnd);   // While t <= tEnd and burst count < maxNumBurst
+    unsigned long run();                        // Until maxTimeSimulation or maxNumBurst
+    bool finished() const;
+
+    void addStepObserver(StepObserver obs);
+    void addSpikeObserver(SpikeObserver obs);
+    void addEpisodeObserver(EpisodeObserver obs);
+
+    const SimulationParameters &parameters() const { return param; }
+    unsigned int nExcNeurons() const { return nExc; }
+    unsigned int nInhNeurons() const { return nInh; }
+    long double time() const { return t; }
+    unsigned long stepCount() const { return nStep; }
+    unsigned int burstCount() const { return nBurst; }
+    bool inActivePhase() const { return activePhase; }
+    ConstSpan<NeuronState_v_n_a_s> state() const { return ConstSpan<NeuronState_v_n_a_s>(network.data(), network.size()); }
+    const myArrayDouble4 &average() const { return sN; }
+    const vector<actualDoubleP> &iappValues() const { return iapp; }
+    const SpikeTrain &spikeTrain() const { return mSpikeTrain; }
+    string kernelName() const;
+    string solverName() const;                  // "rk4", "rl2": used in the file names
+
+private:
+    // Callable passed to the ODEint stepper, cheap to copy
+    template <class P>
+    struct NeuronSystem {
+        const Simulation *sim;
+        void operator()( const NeuronState_v_n_a_s &x , NeuronState_v_n_a_s &dxdt , long double t ) const {
+            sim->neuronModel<P>(x, dxdt, t);
+        }
+    };
+
+    SimulationParameters param;
+    unsigned int nExc;                          // Amount of excitatory neurons
+    unsigned int nInh;                          // Amount of inhibitory neurons
+    actualDoubleP gsyn;                         // gsynTotal/nNeurons, computed in double
+    actualDoubleP vExc, vInh;                   // Reversal potentials in the precision of the model
+
+    vector<actualDoubleP> iapp;                 // Applied current of each neuron
+    vector<NeuronState_v_n_a_s> network;        // Vector of neurons -> The Network
+    vector<bool> depolarization;                // Parameters needed to detect spikes
+    SpikeTrain mSpikeTrain;
+
+    long double t;
+    unsigned long nStep;
+    bool activePhase;                           // Parameters needed to detect episodes
+    unsigned int nBurst;
+
+    // Carried from one step to the next one
+    accumDoubleP atotExc, atotInh;              // Synaptic drive exc/inh for all cells
+    myArrayDouble4 sN;                          // Average of V N A and S
+
+    // Used by the model while integrating neuron j
+    actualDoubleP iappj, atotExcj, atotInhj;
+
+    // Data of the last step given to the observers
+    vector<SpikeEvent> stepSpikes;
+    vector<myEpisodeDouble4> stepEpisodes;
+
+    vector<StepObserver> stepObservers;
+    vector<SpikeObserver> spikeObservers;
+    vector<EpisodeObserver> episodeObservers;
+
+    void primeFromNetwork();
+
+    template <class P>
+    actualDoubleP membraneDerivative(const NeuronState_v_n_a_s &x, const HHRates &r) const;
+
+    template <class P>
+    void neuronModel( const NeuronState_v_n_a_s &x , NeuronState_v_n_a_s &dxdt , long double t ) const;
+
+    template <class P>
+    void rushLarsenStep(NeuronState_v_n_a_s &x, const actualDoubleP &dt) const;
+
+    template <class P, Solver S>
+    unsigned long advance(unsigned long maxSteps, long double tEnd, bool stopAtMaxBurst);
+
+    template <Solver S>
+    unsigned long dispatchKernel(unsigned long maxSteps, long double tEnd, bool stopAtMaxBurst);
+
+    unsigned long dispatch(unsigned long maxSteps, long double tEnd, bool stopAtMaxBurst);
+    void notifyObservers();
+};
+
+#endif /* SIMULATION_H_ */
@@ -0,0 +1,213 @@
+//============================================================================
+// Name        : Sweep.cpp
+// Created on  : Oct, 2026
+// Author      :
+// Description :
+//   Continuation sweep over vInh or the percentage of excitatory neurons,
+//   see Sweep_allP.h. One Simulation walks all the points: setParameters()
+//   changes the parameter keeping the state of the network.
+// Used by     : HH_BBT2017_allP.cpp
+//============================================================================
+
+#include "Sweep_allP.h"
+
+#include <iostream>     // std::cout
+#include <fstream>      // std::ofstream
+#include <sstream>      // std::ostringstream
+#include <cmath>        // abs, sqrt
+#include <chrono>
+#include <limits>       // std::numeric_limits
+
+using namespace std;
+
+static double elapsed(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+}
+
+// Mean and CV of x, NaN if not defined
+static void meanCV(const vector<double> &x, double &mean, double &cv) {
+    const double nan = numeric_limits<double>::quiet_NaN();
+    mean = cv = nan;
+    if (x.empty())
+        return;
+    double sum = 0, sum2 = 0;
+    for (double v : x)
+        sum += v;
+    mean = sum/x.size();
+    for (double v : x)
+        sum2 += (v-mean)*(v-mean);
+    if (x.size() > 1 && mean != 0)
+        cv = sqrt(sum2/(x.size()-1))/mean;
+}
+
+Sweep::Sweep(const SimulationParameters &p, const SweepParameters &sp) :
+        param(p), sp(sp), seconds(0), transientBursts(0), skippedBursts(0), transientEnd(0) {
+}
+
+Sweep::~Sweep() {
+}
+
+string Sweep::variableName() const {
+    return sp.variable == SweepVariable::PExcN ? "pExcN" : "vInh";
+}
+
+void Sweep::run() {
+    auto t0 = chrono::steady_clock::now();
+    Simulation sim(param);
+
+    // Burst k+1 starts with k bursts counted, and the count is already k+1
+    // when it ends
+    sim.addEpisodeObserver([this](const Simulation &sim, ConstSpan<myEpisodeDouble4> episodes) {
+        for (const myEpisodeDouble4 &sA : episodes) {
+            if (sA[2] >= 0) {                                   // Start of the episode
+                if (sim.burstCount() >= skippedBursts)
+                    starts.push_back((double) sA[2]);
+            } else if (sim.burstCount() == skippedBursts)
+                transientEnd = -(double) sA[2];
+            else if (sim.burstCount() > skippedBursts && ends.size() < starts.size())
+                ends.push_back(-(double) sA[2]);
+        }
+    });
+
+    points.clear();
+    for (size_t k = 0; k < sp.values.size(); k++) {
+        if (sp.cold && k > 0)
+            sim.init();
+        runPoint(sim, sp.values[k], sp.cold || k == 0);
+    }
+    seconds = elapsed(t0);
+}
+
+void Sweep::runPoint(Simulation &sim, double value, bool fromInitialConditions) {
+    auto t0 = chrono::steady_clock::now();
+    SimulationParameters pointParam = param;
+
+    transientBursts = sp.transientBursts;
+    if (fromInitialConditions && transientBursts == 0)
+        transientBursts = 1;
+    if (sp.variable == SweepVariable::PExcN)
+        pointParam.pExcNeurons = value;
+    else
+        pointParam.vInh = value;
+    // A point that starts inside a burst (the previous one stopped on time)
+    // counts the end of that burst, which is skipped too
+    skippedBursts = transientBursts + (sim.inActivePhase() ? 1 : 0);
+    pointParam.maxNumBurst = param.maxNumBurst + skippedBursts;
+    sim.setParameters(pointParam);
+
+    starts.clear();
+    ends.clear();
+    const long double tStart = sim.time();
+    const unsigned long stepStart = sim.stepCount();
+    transientEnd = skippedBursts == 0 ? tStart : -1;
+
+    sim.runUntil(tStart + param.maxTimeSimulation);
+
+    SweepPoint p;
+    p.value = value;
+    p.nExc = sim.nExcNeurons();
+    p.nInh = sim.nInhNeurons();
+    p.transientBursts = transientBursts;
+    if (transientEnd >= 0) {
+        p.transient = (double) (transientEnd-tStart);
+        p.recorded = (double) (sim.time()-transientEnd);
+    } else {                                                    // The transient did not end
+        p.transient = (double) (sim.time()-tStart);
+        p.recorded = 0;
+    }
+    p.nBursts = ends.size();
+    p.bursting = !starts.empty();
+
+    vector<double> ibi, duration;
+    for (size_t k = 1; k < starts.size(); k++)
+        ibi.push_back(starts[k]-starts[k-1]);
+    for (size_t k = 0; k < ends.size(); k++)
+        duration.push_back(ends[k]-starts[k]);
+    p.nIbi = ibi.size();
+    meanCV(ibi, p.ibiMean, p.ibiCV);
+    meanCV(duration, p.durationMean, p.durationCV);
+
+    p.steps = sim.stepCount()-stepStart;
+    p.seconds = elapsed(t0);
+    detectChange(p);
+    points.push_back(p);
+
+    cout << "<" << p.nExc << "," << sim.parameters().vInh << ">" << " " << variableName() << " = " << value
+            << ", bursts: " << p.nBursts << ", IBI: " << p.ibiMean << " ms, duration: " << p.durationMean
+            << " ms, transient: " << p.transient << " ms, " << p.change << endl;
+}
+
+// Relative change of the mean from m1 to m2 if it is larger than jump and
+// than 2 standard errors of the difference, 0 otherwise or with less than 2
+// values in a point (no spread to compare with)
+static double meanJump(double m1, double cv1, unsigned int n1, double m2, double cv2, unsigned int n2, double jump) {
+    if (n1 < 2 || n2 < 2)
+        return 0;
+    double d = (m2-m1)/m1;
+    double se1 = cv1*m1/sqrt(n1), se2 = cv2*m2/sqrt(n2);
+    if (!(abs(d) > jump) || !(abs(m2-m1) > 2*sqrt(se1*se1+se2*se2)))
+        return 0;
+    return d;
+}
+
+void Sweep::detectChange(SweepPoint &p) const {
+    p.change = "-";
+    if (points.empty())
+        return;
+
+    const SweepPoint &prev = points.back();
+    if (p.bursting != prev.bursting) {
+        p.change = p.bursting ? "bursting starts" : "bursting stops";
+        return;
+    }
+
+    ostringstream change;
+    double dIbi = meanJump(prev.ibiMean, prev.ibiCV, prev.nIbi, p.ibiMean, p.ibiCV, p.nIbi, sp.jump);
+    double dDuration = meanJump(prev.durationMean, prev.durationCV, prev.nBursts,
+                                p.durationMean, p.durationCV, p.nBursts, sp.jump);
+    change.precision(0);
+    change.setf(ios::fixed, ios::floatfield);
+    change.setf(ios::showpos);
+    if (dIbi != 0)
+        change << "IBI " << dIbi*100 << "% ";
+    if (dDuration != 0)
+        change << "duration " << dDuration*100 << "% ";
+    string s = change.str();
+    if (!s.empty())
+        p.change = s.substr(0, s.size()-1);
+}
+
+void Sweep::writeFile(string const fileName, string const description) const {
+    cout << "Writing in file: "<< fileName << endl;
+    ofstream file(fileName);
+    file.precision(6);
+    file << "# " << description
+            << (sp.cold ? ", each point from the initial conditions" : ", continuation") << "\n"
+            << "# " << variableName() << "\tnExc\tnInh\ttransient bursts\ttransient (ms)\trecorded (ms)\tbursts"
+            << "\tIBI mean (ms)\tIBI CV\tduration mean (ms)\tduration CV\tsteps\tseconds\tchange\n";
+    for (const SweepPoint &p : points)
+        file << p.value << "\t" << p.nExc << "\t" << p.nInh << "\t" << p.transientBursts << "\t" << p.transient << "\t" << p.recorded
+                << "\t" << p.nBursts << "\t" << p.ibiMean << "\t" << p.ibiCV << "\t" << p.durationMean
+                << "\t" << p.durationCV << "\t" << p.steps << "\t" << p.seconds << "\t" << p.change << "\n";
+    file.close();
+}
+
+void Sweep::printReport(ostream &out) const {
+    unsigned long steps = 0, transientSteps = 0;
+    double transient = 0;
+    for (const SweepPoint &p : points) {
+        steps += p.steps;
+        transient += p.transient;
+    }
+    transientSteps = (unsigned long) (transient/param.dt + 0.5);
+
+    out << "Sweep of " << variableName() << ": " << points.size() << " points, "
+            << sp.transientBursts << " transient bursts per point, "
+            << (sp.cold ? "each point from the initial conditions" : "continuation") << "\n";
+    out << "Wall time: " << seconds << " s, " << steps << " steps, "
+            << transientSteps << " of them in the transients (" << transient << " ms)\n";
+    for (const SweepPoint &p : points)
+        if (p.change != "-")
+            out << "  " << variableName() << " = " << p.value << ": " << p.change << "\n";
+    out.flush();
+}
@@ -0,0 +1,90 @@
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+// Continuation sweep: an ordered list of values of vInh or of the
+// percentage of excitatory neurons simulated in one process. Each point
+// starts from the state of the network where the previous one stopped (the
+// first one from the initial conditions), so it is already near its
+// attractor; the first transientBursts bursts of each point are skipped.
+// A point that starts from the initial conditions skips at least 1 burst:
+// the first one, ~100 ms after t = 0, is an artifact of them.
+// Each point runs until maxNumBurst recorded bursts or maxTimeSimulation ms.
+// A point that starts inside a burst (the previous one stopped on time)
+// also skips the end of that burst.
+// The burst statistics of each point are compared with the previous one to
+// flag the qualitative changes: bursting that starts or stops (no burst
+// after the transient), and jumps of the mean inter-burst interval or burst
+// duration. The IBIs of the network are irregular (chaotic), so a jump must
+// be larger than jump*mean and than 2 standard errors of the difference
+// (at least 2 intervals in both points).
+
+#include <vector>
+#include <string>       // std::string, std::to_string
+#include <ostream>
+
+#include "checkActualPrecision.h"
+#include "Simulation_allP.h"
+
+using namespace std;
+
+// Swept parameter
+enum class SweepVariable {
+    VInh,                                       // Reversal potential of inhibitory synapses
+    PExcN                                       // Percentage of excitatory neurons
+};
+
+struct SweepParameters {
+    SweepVariable variable = SweepVariable::VInh;
+    vector<double> values;                      // In the order of the sweep
+    unsigned int transientBursts = 0;           // Bursts skipped at the start of each point
+    double jump = 0.25;                         // Min relative change of the mean IBI/duration flagged
+    bool cold = false;                          // true: each point from the initial conditions (to compare)
+};
+
+// Burst statistics of a point
+struct SweepPoint {
+    double value;
+    unsigned int nExc, nInh;
+    unsigned int transientBursts;
+    double transient;                           // Time until the end of the transient bursts: ms
+    double recorded;                            // Time recorded after the transient: ms
+    unsigned int nBursts;                       // Complete bursts recorded
+    bool bursting;                              // Some burst started after the transient
+    unsigned int nIbi;
+    double ibiMean, ibiCV;                      // Inter-burst interval, start to start: ms
+    double durationMean, durationCV;            // Burst duration: ms
+    unsigned long steps;
+    double seconds;                             // Wall time
+    string change;                              // Qualitative change from the previous point, "-": none
+};
+
+class Sweep {
+    SimulationParameters param;                 // maxNumBurst: recorded bursts
+    SweepParameters sp;
+    vector<SweepPoint> points;
+    double seconds;
+
+    // Episodes of the current point, after the transient
+    unsigned int transientBursts;
+    unsigned int skippedBursts;                 // transientBursts, +1 if the point starts inside a burst
+    vector<double> starts, ends;
+    long double transientEnd;
+
+    void runPoint(Simulation &sim, double value, bool fromInitialConditions);
+    void detectChange(SweepPoint &p) const;
+
+public:
+    Sweep(const SimulationParameters &p, const SweepParameters &sp);
+    virtual ~Sweep();
+
+    void run();
+
+    const vector<SweepPoint> &results() const { return points; }
+    string variableName() const;                // "vInh", "pExcN"
+
+    // One row per point
+    void writeFile(string const fileName, string const description) const;
+    void printReport(ostream &out) const;
+};
+
+#endif /* SWEEP_H_ */
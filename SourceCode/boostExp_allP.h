@@ -0,0 +1,98 @@
+#ifndef BOOSTEXP_H_
+#define BOOSTEXP_H_
+
+// Table driven exp(x) for the Boost precision (cpp_dec_float_100).
+//
+// The exp of Boost.Multiprecision sums the Taylor series of x (about 60
+// terms, each one with a division) and it is about the whole cost of a
+// step of the model in the Boost precision. This version reduces the
+// argument with tables and only needs a short polynomial:
+//
+// Method: m = trunc(x*2^32), x = m/2^32 + r, |r| < 2^-32 (m/2^32 and r are
+// exact in decimal), m = n*2^32 + j1*2^24 + j2*2^16 + j3*2^8 + j4 with
+// n = floor(m/2^32), j1..j4 = 0..255,
+// exp(x) = e^n * e^(j1/2^8) * e^(j2/2^16) * e^(j3/2^24) * e^(j4/2^32) * p(r),
+// with the tables computed once with the exp of Boost and p(r) the degree 9
+// Taylor polynomial of exp(r) (Horner scheme, truncation error < 1e-103).
+// Relative error < 3e-101, the epsilon of the type is 1e-99.
+// Outside |x| < xMax (and NaN) the exp of Boost is used.
+//
+// The operations are done in place, without the temporaries of the
+// expression templates.
+
+#include <vector>
+
+#include "checkActualPrecision.h"
+
+namespace boostexp {
+
+const int nMax = 256;                   // e^n table for |n| <= nMax
+const int nLevels = 4;                  // e^(j/2^(8*l)) tables, l = 1..nLevels, j = 0..255
+const long nTab = 256;
+const int K = 9;                        // Degree of the polynomial
+
+struct Tables {
+    actualDoubleP xMax;
+    actualDoubleP scale, invScale;      // 2^32, 2^-32 (exact in decimal)
+    std::vector<actualDoubleP> eInt;    // e^n, n = -nMax..nMax
+    std::vector<actualDoubleP> eFrac[nLevels];
+    actualDoubleP c[K+1];               // 1/k!
+
+    Tables() : xMax(nMax), scale(1), invScale(1), eInt(2*nMax+1) {
+        actualDoubleP step = 1;         // 2^(-8*l)
+        for (int l = 0; l < nLevels; l++) {
+            step /= nTab;
+            eFrac[l].resize(nTab);
+            for (long j = 0; j < nTab; j++)
+                eFrac[l][j] = exp(j*step);
+            scale *= nTab;
+        }
+        invScale = step;
+        for (int n = -nMax; n <= nMax; n++)
+            eInt[n+nMax] = exp(actualDoubleP(n));
+        c[0] = 1;
+        for (int k = 1; k <= K; k++)
+            c[k] = c[k-1]/k;
+    }
+};
+
+// Built on first use (thread safe)
+inline const Tables &tables() {
+    static const Tables tab;
+    return tab;
+}
+
+} // namespace boostexp
+
+inline actualDoubleP boostExp(const actualDoubleP &x) {
+    using namespace boostexp;
+    const Tables &tab = tables();
+
+    if (!(abs(x) < tab.xMax))
+        return exp(x);
+
+    // Argument reduction: m = trunc(x*2^32), r = x - m/2^32
+    actualDoubleP r = x;
+    r *= tab.scale;
+    const long long m = r.convert_to<long long>();
+    r = m;
+    r *= tab.invScale;
+    r = x - r;
+    const long long mScale = 1LL << (8*nLevels);
+    long long n = (m >= 0 ? m : m - (mScale-1))/mScale;    // floor(m/2^32)
+    long long j = m - n*mScale;                             // 0..2^32-1
+
+    // p(r) = exp(r)
+    actualDoubleP p = tab.c[K];
+    for (int k = K-1; k >= 0; k--) {
+        p *= r;
+        p += tab.c[k];
+    }
+
+    for (int l = nLevels-1; l >= 0; l--, j /= nTab)
+        p *= tab.eFrac[l][j % nTab];
+    p *= tab.eInt[n+nMax];
+    return p;
+}
+
+#endif /* BOOSTEXP_H_ */
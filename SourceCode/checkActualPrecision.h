@@ -3,20 +3,72 @@
 
 #include <string>       // std::string, std::to_string
 
-#ifdef useLongDoubleP                                   // Case -DuseLongDoubleP is defined as parameter to the compiler 
+// actualDoubleP: neuron state and integration of the model
+// accumDoubleP : population reductions (synaptic drive, averages, totals)
+#ifdef useLongDoubleP                                   // Case -DuseLongDoubleP is defined as parameter to the compiler
     typedef long double actualDoubleP;
+    typedef long double accumDoubleP;
     std::string const actualPrecisionType = "long_double";
-#else 
-    #ifdef useBoostDoubleP                              // Case -DuseBoostDoubleP is defined as parameter to the compiler 
+#else
+    #ifdef useBoostDoubleP                              // Case -DuseBoostDoubleP is defined as parameter to the compiler
         #include <boost/multiprecision/cpp_dec_float.hpp>
         using namespace boost::multiprecision;
-        
-        typedef cpp_dec_float_100 actualDoubleP;
-        std::string const actualPrecisionType = "boost_double";
+
+        #ifdef useBoostEtOff                            // Case -DuseBoostEtOff: without expression templates
+            typedef number<cpp_dec_float<100>, et_off> actualDoubleP;
+        #else
+            typedef cpp_dec_float_100 actualDoubleP;
+        #endif
+        typedef actualDoubleP accumDoubleP;
+        #ifdef useBoostLibExp                           // Case -DuseBoostLibExp: exp of Boost instead of boostExp_allP.h
+            std::string const actualPrecisionType = "boost_double_libExp";
+        #else
+            std::string const actualPrecisionType = "boost_double";
+        #endif
     #else
-        typedef double actualDoubleP;                   // default: double precision
-        std::string const actualPrecisionType = "double";
+        #ifdef useFloatP                                // Case -DuseFloatP: single precision
+            typedef float actualDoubleP;
+            typedef float accumDoubleP;
+            std::string const actualPrecisionType = "float";
+        #else
+            #ifdef useMixedP                            // Case -DuseMixedP: single precision state and RK4 stages,
+                typedef float actualDoubleP;            // double precision population reductions
+                typedef double accumDoubleP;
+                std::string const actualPrecisionType = "mixed_float";
+            #else
+                typedef double actualDoubleP;           // default: double precision
+                typedef double accumDoubleP;
+                #ifdef useDetExp                        // Case -DuseDetExp: bundled deterministic exp, see detExp_allP.h
+                    std::string const actualPrecisionType = "double_detExp";
+                #else
+                    std::string const actualPrecisionType = "double";
+                #endif
+            #endif
+        #endif
     #endif
 #endif
 
+#if defined(useDetExp) && (defined(useLongDoubleP) || defined(useBoostDoubleP) || defined(useFloatP) || defined(useMixedP))
+    #error "-DuseDetExp is only available for double precision"
+#endif
+#if defined(useBoostLibExp) && !defined(useBoostDoubleP)
+    #error "-DuseBoostLibExp is only available for the Boost precision"
+#endif
+
+// Values of the episodes (Aexc, Ainh, start/end time). A float time at 8 s
+// is only accurate to ~0.0005 ms, in single precision they are kept in double
+#ifdef useFloatP
+    typedef double episodeDoubleP;
+#else
+    typedef accumDoubleP episodeDoubleP;
+#endif
+
+// Value of the state in the precision of the reductions (no copy when both
+// precisions are the same)
+#ifdef useMixedP
+    inline accumDoubleP toAccumP(const actualDoubleP x) { return x; }
+#else
+    inline const accumDoubleP &toAccumP(const actualDoubleP &x) { return x; }
+#endif
+
 #endif /* CHECKACTUALPRECISION_H_ */
@@ -0,0 +1,124 @@
+//============================================================================
+// Name        : compareFingerprint.cpp
+// Created on  : Oct, 2026
+// Author      :
+// Description :
+//   Compares the fingerprint logs (",Fingerprint.txt") of two runs, usually
+//   of different platforms, and finds the first differing step by binary
+//   search: the hashes are chained, so once two runs differ all the
+//   following hashes differ.
+//   The window of steps around that step can then be re-run on both
+//   platforms with -traceFrom/-traceTo to get the full state of every neuron.
+//============================================================================
+
+#include <iostream>     // std::cout
+#include <fstream>      // std::ifstream
+#include <sstream>      // std::istringstream
+#include <string>       // std::string, std::to_string
+#include <vector>
+#include <algorithm>    // std::min
+
+using namespace std;
+
+struct FingerprintEntry {
+    unsigned long step;
+    string time;
+    string hash;
+    unsigned long spikes;
+};
+
+bool readFingerprint(const string &fileName, vector<string> &header, vector<FingerprintEntry> &entries) {
+    ifstream f(fileName);
+    if (!f) {
+        cerr << "Can not open " << fileName << endl;
+        return false;
+    }
+    string line;
+    while (getline(f, line)) {
+        if (line.empty())
+            continue;
+        if (line[0] == '#') {
+            header.push_back(line);
+            continue;
+        }
+        istringstream ss(line);
+        FingerprintEntry e;
+        if (ss >> e.step >> e.time >> e.hash >> e.spikes)
+            entries.push_back(e);
+    }
+    return true;
+}
+
+void showUsage(string name)
+{
+    cerr << "Usage: " << name << " <fingerprint file A> <fingerprint file B>\n"
+            << "Options:\n"
+            << "\t-h,--help\t\tShow this help message\n"
+            << endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc != 3 || string(argv[1]) == "-h" || string(argv[1]) == "--help") {
+        showUsage(argv[0]);
+        exit(0);
+    }
+
+    vector<string> headerA, headerB;
+    vector<FingerprintEntry> a, b;
+    if (!readFingerprint(argv[1], headerA, a) || !readFingerprint(argv[2], headerB, b))
+        exit(1);
+
+    cout << "A: " << argv[1] << "\n";
+    for (const string &h : headerA)
+        cout << "   " << h << "\n";
+    cout << "B: " << argv[2] << "\n";
+    for (const string &h : headerB)
+        cout << "   " << h << "\n";
+    cout << "Entries: A " << a.size() << ", B " << b.size() << "\n\n";
+
+    size_t n = min(a.size(), b.size());
+    if (n == 0) {
+        cout << "Nothing to compare" << endl;
+        return 0;
+    }
+    for (size_t i = 0; i < min(n, (size_t) 2); i++)
+        if (a[i].step != b[i].step) {
+            cerr << "The fingerprints were not logged at the same steps (-fingerprint k)" << endl;
+            exit(1);
+        }
+
+    if (a[n-1].hash == b[n-1].hash) {
+        cout << "Identical up to step " << a[n-1].step << " (t = " << a[n-1].time << " ms)\n";
+        if (a.size() != b.size())
+            cout << "The runs stopped at different steps, A at " << a.back().step
+                    << " and B at " << b.back().step << "\n";
+        return 0;
+    }
+
+    // First entry with a different hash
+    size_t lo = 0, hi = n-1;
+    while (lo < hi) {
+        size_t mid = lo + (hi-lo)/2;
+        if (a[mid].hash == b[mid].hash)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+
+    const FingerprintEntry &ea = a[lo], &eb = b[lo];
+    unsigned long windowFrom = 0;
+    if (lo > 0) {
+        windowFrom = a[lo-1].step+1;
+        cout << "Identical up to step " << a[lo-1].step << " (t = " << a[lo-1].time << " ms), "
+                << a[lo-1].spikes << " spikes\n";
+    } else
+        cout << "Different from the first logged step\n";
+    cout << "First differing logged step " << ea.step << " (t = " << ea.time << " ms)\n"
+            << "   A: hash " << ea.hash << ", " << ea.spikes << " spikes\n"
+            << "   B: hash " << eb.hash << ", " << eb.spikes << " spikes\n\n"
+            << "The first difference is in the steps " << windowFrom << " .. " << ea.step << ", re-run both with:\n"
+            << "   <same options> -traceFrom " << windowFrom << " -traceTo " << ea.step << "\n";
+
+    return 0;
+}
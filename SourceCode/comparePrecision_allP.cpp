@@ -0,0 +1,353 @@
+//============================================================================
+// Name        : comparePrecision.cpp
+// Created on  : Oct, 2026
+// Author      :
+// Description :
+//   Compares the results of a simulation (test) with a reference one, usually
+//   the double precision run, to measure how the episode and spike statistics
+//   degrade with a cheaper precision (ex: -DuseFloatP, -DuseMixedP).
+//   It reads the files written by HH_BBT2017_allP.exe:
+//   - ",Epis.txt"  : Aexc, Ainh, +/-time episode, 1
+//   - "_Spikes.m"  : spikeTimes{k} = [ t1 t2 ... ];
+//   - ".txt"       : average of V N A and S per step (optional)
+//============================================================================
+
+#include <iostream>     // std::cout
+#include <fstream>      // std::ifstream
+#include <sstream>      // std::istringstream
+#include <string>       // std::string, std::to_string
+#include <vector>
+#include <cmath>        // abs, sqrt
+#include <limits>
+#include <algorithm>    // std::min, std::max
+#include <cstdlib>      // strtod
+
+using namespace std;
+
+// Files to compare
+string refEpisFile, testEpisFile;
+string refSpikesFile, testSpikesFile;
+string refTraceFile, testTraceFile;
+
+double tol = 1.0;                               // Tolerance for the times: ms
+double dt = 0.01;                               // Time step of the trace: ms
+double traceTolA = 0.01;                        // Tolerance for the average activity A
+
+struct Episode {
+    double start, end;                          // ms
+};
+
+// Statistics of a sequence of intervals
+struct IntervalStats {
+    size_t n = 0;
+    double mean = 0;
+    double cv = 0;
+};
+
+IntervalStats intervalStats(const vector<double> &x) {
+    IntervalStats st;
+    st.n = x.size();
+    if (st.n == 0)
+        return st;
+    double sum = 0, sum2 = 0;
+    for (double v : x)
+        sum += v;
+    st.mean = sum/st.n;
+    for (double v : x)
+        sum2 += (v-st.mean)*(v-st.mean);
+    if (st.n > 1 && st.mean != 0)
+        st.cv = sqrt(sum2/(st.n-1))/st.mean;
+    return st;
+}
+
+//==========
+// Readers
+//==========
+
+// Reads n values. The files can contain nan (ex: Ainh without
+// inhibitory neurons), that operator>> does not accept
+bool readValues(istream &f, double *x, int n) {
+    string token;
+    for (int i = 0; i < n; i++) {
+        if (!(f >> token))
+            return false;
+        x[i] = strtod(token.c_str(), NULL);
+    }
+    return true;
+}
+
+// Episodes: the start is saved with a positive time, the end with a negative one
+bool readEpisodes(const string &fileName, vector<Episode> &episodes) {
+    ifstream f(fileName);
+    if (!f) {
+        cerr << "Can not open " << fileName << endl;
+        return false;
+    }
+    double row[4];                              // Aexc, Ainh, +/-time episode, 1
+    bool open = false;
+    Episode e = {0, 0};
+    while (readValues(f, row, 4)) {
+        double time = row[2];
+        if (time >= 0) {
+            e.start = time;
+            open = true;
+        } else if (open) {
+            e.end = -time;
+            episodes.push_back(e);
+            open = false;
+        }
+    }
+    return true;
+}
+
+// Spikes: one line per neuron, spikeTimes{k} = [ t1 t2 ... ];
+bool readSpikes(const string &fileName, vector< vector<double> > &spikes) {
+    ifstream f(fileName);
+    if (!f) {
+        cerr << "Can not open " << fileName << endl;
+        return false;
+    }
+    string line;
+    while (getline(f, line)) {
+        size_t b = line.find('[');
+        size_t e = line.find(']');
+        if (b == string::npos || e == string::npos)
+            continue;
+        istringstream ss(line.substr(b+1, e-b-1));
+        vector<double> times;
+        double t;
+        while (ss >> t)
+            times.push_back(t);
+        spikes.push_back(times);
+    }
+    return true;
+}
+
+//==========
+// Reports
+//==========
+
+void printRow(const string &name, double ref, double test) {
+    cout << "  " << name;
+    for (size_t i = name.size(); i < 28; i++)
+        cout << ' ';
+    cout << ref << "\t" << test << "\t";
+    if (ref != 0)
+        cout << 100*(test-ref)/abs(ref) << " %";
+    cout << "\n";
+}
+
+void compareEpisodes(const vector<Episode> &ref, const vector<Episode> &test) {
+    vector<double> ibiRef, ibiTest, durRef, durTest;
+    for (size_t k = 0; k < ref.size(); k++) {
+        durRef.push_back(ref[k].end-ref[k].start);
+        if (k > 0)
+            ibiRef.push_back(ref[k].start-ref[k-1].start);
+    }
+    for (size_t k = 0; k < test.size(); k++) {
+        durTest.push_back(test[k].end-test[k].start);
+        if (k > 0)
+            ibiTest.push_back(test[k].start-test[k-1].start);
+    }
+    IntervalStats iR = intervalStats(ibiRef), iT = intervalStats(ibiTest);
+    IntervalStats dR = intervalStats(durRef), dT = intervalStats(durTest);
+
+    cout << "Episodes\t\t\t    reference\ttest\t\tdifference\n";
+    printRow("Episodes", ref.size(), test.size());
+    printRow("Mean inter-burst (ms)", iR.mean, iT.mean);
+    printRow("CV inter-burst", iR.cv, iT.cv);
+    printRow("Mean duration (ms)", dR.mean, dT.mean);
+
+    // Episodes matched by their order
+    size_t n = min(ref.size(), test.size());
+    double sum = 0, maxDiff = 0;
+    long firstDiverged = -1;
+    for (size_t k = 0; k < n; k++) {
+        double d = abs(test[k].start-ref[k].start);
+        sum += d;
+        maxDiff = max(maxDiff, d);
+        if (firstDiverged < 0 && d > tol)
+            firstDiverged = k;
+    }
+    cout << "  Matched episodes: " << n << ", |start difference| mean " << (n ? sum/n : 0)
+            << " ms, max " << maxDiff << " ms\n";
+    if (firstDiverged >= 0)
+        cout << "  First episode with |start difference| > " << tol << " ms: #" << firstDiverged+1
+                << " (reference start " << ref[firstDiverged].start << " ms)\n";
+    else
+        cout << "  All matched episodes start within " << tol << " ms\n";
+    cout << endl;
+}
+
+void compareSpikes(const vector< vector<double> > &ref, const vector< vector<double> > &test) {
+    size_t nNeurons = min(ref.size(), test.size());
+    vector<double> isiRef, isiTest;
+    size_t totalRef = 0, totalTest = 0, sameCount = 0;
+    size_t matched = 0, withinTol = 0;
+    double sum = 0, maxDiff = 0;
+    double divergence = numeric_limits<double>::infinity();
+
+    for (size_t i = 0; i < nNeurons; i++) {
+        const vector<double> &r = ref[i], &s = test[i];
+        totalRef += r.size();
+        totalTest += s.size();
+        if (r.size() == s.size())
+            sameCount++;
+        for (size_t k = 1; k < r.size(); k++)
+            isiRef.push_back(r[k]-r[k-1]);
+        for (size_t k = 1; k < s.size(); k++)
+            isiTest.push_back(s[k]-s[k-1]);
+
+        // Spikes matched by their order, the first one out of the tolerance
+        // (or the first one without a pair) gives the divergence time
+        size_t n = min(r.size(), s.size());
+        for (size_t k = 0; k < n; k++) {
+            double d = abs(s[k]-r[k]);
+            sum += d;
+            maxDiff = max(maxDiff, d);
+            matched++;
+            if (d <= tol)
+                withinTol++;
+            else
+                divergence = min(divergence, min(r[k], s[k]));
+        }
+        if (r.size() > n)
+            divergence = min(divergence, r[n]);
+        if (s.size() > n)
+            divergence = min(divergence, s[n]);
+    }
+    IntervalStats iR = intervalStats(isiRef), iT = intervalStats(isiTest);
+
+    cout << "Spikes\t\t\t\t    reference\ttest\t\tdifference\n";
+    printRow("Spikes", totalRef, totalTest);
+    printRow("Mean inter-spike (ms)", iR.mean, iT.mean);
+    printRow("CV inter-spike", iR.cv, iT.cv);
+    cout << "  Neurons with the same spike count: " << sameCount << "/" << nNeurons << "\n";
+    cout << "  Matched spikes: " << matched << ", |time difference| mean " << (matched ? sum/matched : 0)
+            << " ms, max " << maxDiff << " ms, within " << tol << " ms: "
+            << (matched ? 100.0*withinTol/matched : 0) << " %\n";
+    if (divergence < numeric_limits<double>::infinity())
+        cout << "  Spike trains diverge (> " << tol << " ms) at t = " << divergence << " ms\n";
+    else
+        cout << "  Spike trains do not diverge\n";
+    cout << endl;
+}
+
+// Average trace, streamed line by line (the files are large)
+bool compareTrace(const string &refFile, const string &testFile) {
+    ifstream fr(refFile), ft(testFile);
+    if (!fr || !ft) {
+        cerr << "Can not open " << (fr ? testFile : refFile) << endl;
+        return false;
+    }
+    double r[4], s[4];
+    double maxDiff[4] = {0, 0, 0, 0}, sum2[4] = {0, 0, 0, 0};
+    unsigned long rows = 0;
+    double divergence = -1;
+    while (readValues(fr, r, 4) && readValues(ft, s, 4)) {
+        for (int j = 0; j < 4; j++) {
+            double d = abs(s[j]-r[j]);
+            maxDiff[j] = max(maxDiff[j], d);
+            sum2[j] += d*d;
+        }
+        if (divergence < 0 && abs(s[2]-r[2]) > traceTolA)
+            divergence = rows*dt;
+        rows++;
+    }
+    const char *names[4] = {"V", "N", "A", "S"};
+    cout << "Average trace (" << rows << " steps)\n";
+    for (int j = 0; j < 4; j++)
+        cout << "  " << names[j] << ": max |difference| " << maxDiff[j]
+                << ", RMS " << (rows ? sqrt(sum2[j]/rows) : 0) << "\n";
+    if (divergence >= 0)
+        cout << "  |A difference| > " << traceTolA << " from t = " << divergence << " ms\n";
+    else
+        cout << "  |A difference| <= " << traceTolA << " for the whole trace\n";
+    cout << endl;
+    return true;
+}
+
+void showUsage(string name)
+{
+    cerr << "Usage: " << name << " <option(s)>\n"
+            << "Options:\n"
+            << "\t-h,--help\t\tShow this help message\n"
+            << "\t-refEpis\t<Episodes file of the reference run (,Epis.txt)>\n"
+            << "\t-testEpis\t<Episodes file of the tested run>\n"
+            << "\t-refSpikes\t<Spikes file of the reference run (_Spikes.m)>\n"
+            << "\t-testSpikes\t<Spikes file of the tested run>\n"
+            << "\t-refTrace\t<Optional, average trace of the reference run (.txt)>\n"
+            << "\t-testTrace\t<Optional, average trace of the tested run>\n"
+            << "\t-tol\t<Tolerance for episode and spike times, ms, default 1.0>\n"
+            << "\t-dt\t<Time step of the traces, ms, default 0.01>\n"
+            << endl;
+}
+
+int parseParameters(int argc, char* argv[]) {
+
+    for (int i = 1; i < argc; i+=2) {
+        string opt = argv[i];
+        if (opt == "-h" || opt == "--help") {
+            showUsage(argv[0]);
+            return -1;
+        }
+        if (i + 1 >= argc) {                    // Uh-oh, there was no argument to the option.
+            std::cerr << opt << " option requires one argument." << std::endl;
+            return -1;
+        }
+        string value = argv[i + 1];
+        if (opt == "-refEpis")
+            refEpisFile = value;
+        else if (opt == "-testEpis")
+            testEpisFile = value;
+        else if (opt == "-refSpikes")
+            refSpikesFile = value;
+        else if (opt == "-testSpikes")
+            testSpikesFile = value;
+        else if (opt == "-refTrace")
+            refTraceFile = value;
+        else if (opt == "-testTrace")
+            testTraceFile = value;
+        else if (opt == "-tol")
+            tol = strtod(value.c_str(), NULL);
+        else if (opt == "-dt")
+            dt = strtod(value.c_str(), NULL);
+        else {
+            std::cerr << "Unknown option " << opt << std::endl;
+            showUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (refEpisFile.empty() || testEpisFile.empty() || refSpikesFile.empty() || testSpikesFile.empty()) {
+        showUsage(argv[0]);
+        return -1;
+    }
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (parseParameters(argc, argv)<0)
+        exit(0);
+
+    vector<Episode> episodesRef, episodesTest;
+    vector< vector<double> > spikesRef, spikesTest;
+
+    if (!readEpisodes(refEpisFile, episodesRef) || !readEpisodes(testEpisFile, episodesTest) ||
+            !readSpikes(refSpikesFile, spikesRef) || !readSpikes(testSpikesFile, spikesTest))
+        exit(1);
+
+    cout.precision(4);
+    std::cout.setf( std::ios::fixed, std:: ios::floatfield );
+
+    cout << "Reference: " << refEpisFile << "\n"
+            << "Test     : " << testEpisFile << "\n\n";
+
+    compareEpisodes(episodesRef, episodesTest);
+    compareSpikes(spikesRef, spikesTest);
+    if (!refTraceFile.empty() && !testTraceFile.empty())
+        compareTrace(refTraceFile, testTraceFile);
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+#ifndef DETEXP_H_
+#define DETEXP_H_
+
+// Deterministic exp(x) for double precision, scalar and SIMD versions.
+//
+// The results of the system libm exp differ between Windows, MacOS and
+// Linux toolchains. This implementation only uses IEEE 754 +, -, *, / in
+// round-to-nearest, a table of constants and integer bit operations, so it
+// gives the same bits on every platform and compiler (it is not correctly
+// rounded: error < 0.52 ulp for normal results, < 0.77 ulp for subnormal
+// results, x < -708.4, where the last product rounds a second time).
+// The scalar and the SIMD versions do the same operations in the same
+// order, so they give the same bits too.
+//
+// Requirements: SSE2 or any other IEEE double arithmetic (no x87 excess
+// precision), and no contraction of a*b+c into FMA (default on aarch64 and
+// on x86 with FMA). The pragmas below disable it for the rest of the
+// translation unit, so also for the model and the RK4 stepper compiled
+// after this header; the Makefile also passes -ffp-contract=off.
+//
+// Method: x = (k/N)*ln2 + r, N = 128, |r| <= ln2/(2N),
+// exp(x) = 2^(k/N) * exp(r) = 2^e * 2^(j/N) * (1 + p(r)), k = e*N + j,
+// with 2^(j/N) = tabHi[j] + tabLo[j] (rounded to nearest from 80 digits)
+// and p(r) the degree 5 Taylor polynomial of exp(r)-1 (Estrin scheme).
+// 2^e is applied as 2^e1 * 2^e2 so that the overflow/underflow limits
+// are reached without special cases.
+
+#include <cstdint>
+#include <cstring>      // std::memcpy
+#include <cstddef>      // std::size_t
+
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")        // gcc ignores the STDC pragma
+#endif
+
+namespace detexp {
+
+const int N = 128;
+const double invln2N = 184.6649652337873;           // N/ln2
+const double ln2HIN = 0.00541521234663378;          // ln2HI/N, 0x3fe62e42fee00000/N, k*ln2HIN exact
+const double ln2LON = 1.4907929134926466e-12;       // ln2LO/N
+const double C2 = 0.5;
+const double C3 = 0.16666666666666666;
+const double C4 = 0.041666666666666664;
+const double C5 = 0.008333333333333333;
+const double shifter = 6755399441055744.0;          // 1.5*2^52, rounds to integer
+const double xMax = 710.0;                          // exp(xMax) = +inf
+const double xMin = -746.0;                         // exp(xMin) = 0
+const int64_t shifterBits = 0x4338000000000000LL;
+
+// 2^(j/N) = tabHi[j] + tabLo[j]
+const double tabHi[N] = {
+    1.0, 1.0054299011128027, 1.0108892860517005, 1.016378314910953,
+    1.0218971486541166, 1.0274459491187637, 1.0330248790212284, 1.0386341019613787,
+    1.0442737824274138, 1.0499440858006872, 1.0556451783605572, 1.061377227289262,
+    1.0671404006768237, 1.0729348675259756, 1.0787607977571199, 1.0846183622133092,
+    1.0905077326652577, 1.0964290818163769, 1.102382583307841, 1.1083684117236787,
+    1.1143867425958924, 1.1204377524096067, 1.1265216186082418, 1.1326385195987192,
+    1.1387886347566916, 1.1449721444318042, 1.1511892299529827, 1.1574400736337511,
+    1.1637248587775775, 1.1700437696832502, 1.1763969916502812, 1.182784710984341,
+    1.189207115002721, 1.1956643920398273, 1.202156731452703, 1.2086843236265816,
+    1.215247359980469, 1.2218460329727576, 1.22848053610687, 1.2351510639369334,
+    1.241857812073484, 1.2486009771892048, 1.255380757024691, 1.2621973503942507,
+    1.2690509571917332, 1.275941778396392, 1.2828700160787783, 1.2898358734066657,
+    1.2968395546510096, 1.3038812651919358, 1.3109612115247644, 1.318079601266064,
+    1.3252366431597413, 1.3324325470831615, 1.339667524053303, 1.3469417862329458,
+    1.3542555469368927, 1.3616090206382248, 1.3690024229745905, 1.3764359707545302,
+    1.383909881963832, 1.3914243757719262, 1.3989796725383112, 1.4065759938190154,
+    1.4142135623730951, 1.4218926021691656, 1.42961333839197, 1.4373759974489824,
+    1.4451808069770467, 1.4530279958490526, 1.460917794180647, 1.4688504333369818,
+    1.4768261459394993, 1.4848451658727524, 1.4929077282912648, 1.5010140696264256,
+    1.5091644275934228, 1.5173590411982147, 1.5255981507445384, 1.533881997840956,
+    1.5422108254079407, 1.550584877685, 1.559004400237837, 1.567469639965553,
+    1.5759808451078865, 1.5845382652524937, 1.593142151342267, 1.6017927556826934,
+    1.6104903319492543, 1.6192351351948637, 1.6280274218573478, 1.6368674497669644,
+    1.645755478153965, 1.6546917676561943, 1.6636765803267364, 1.6727101796415966,
+    1.681792830507429, 1.6909247992693053, 1.7001063537185235, 1.709337763100463,
+    1.718619298122478, 1.7279512309618377, 1.7373338352737062, 1.746767386199169,
+    1.7562521603732995, 1.7657884359332727, 1.7753764925265212, 1.785016611318935,
+    1.7947090750031072, 1.804454167806624, 1.8142521755003989, 1.8241033854070534,
+    1.8340080864093424, 1.843966568958626, 1.8539791250833855, 1.864046048397789,
+    1.8741676341103, 1.8843441790323345, 1.8945759815869656, 1.9048633418176741,
+    1.9152065613971474, 1.925605943636125, 1.9360617934922943, 1.9465744175792332,
+    1.9571441241754002, 1.9677712232331759, 1.978456026387951, 1.9891988469672663,
+};
+const double tabLo[N] = {
+    0.0, 9.499186535455032e-17, -1.5234778603368577e-17, -5.77217007319966e-17,
+    5.109225028973444e-17, -4.9560741746453704e-17, 7.600838874027088e-18, 5.996273788852511e-17,
+    8.551889705537965e-17, 5.592937848127003e-17, 1.759325738772092e-18, -1.1973537085365658e-17,
+    -7.899853966841582e-17, -3.839668843358824e-18, -6.656660436056593e-17, 3.166152845816346e-17,
+    -3.046782079812471e-17, -5.919933484449316e-17, 5.2660368715706944e-17, -8.786813845180527e-17,
+    1.0410278456845571e-16, -6.201085906554179e-17, 5.165856758795457e-17, 3.237356166738e-17,
+    8.912812676025408e-17, 4.6412898921700107e-17, 3.250710218863827e-17, -9.1238712311344e-17,
+    3.8292048369240935e-17, -1.8477442017900047e-18, 5.554203254218079e-17, 1.542975430079076e-17,
+    3.982015231465646e-17, 4.6166036704814814e-17, 6.644981499252301e-17, -4.746725945228984e-17,
+    -7.712630692681488e-17, -1.0611021211402691e-16, -1.89878163130253e-17, -1.0755244344307841e-16,
+    4.658027591836937e-17, -8.261810999021964e-17, -6.7113898212968784e-18, -3.0844648874738465e-17,
+    2.667932131342186e-18, 9.91543024421429e-17, 1.713594918243561e-17, 8.949257530897592e-17,
+    2.5382502794888315e-17, 8.647675598267871e-17, -7.181536135519454e-17, -5.4579558271491535e-17,
+    -2.8587312100388614e-17, -5.101586630916744e-17, 8.927282594831732e-17, 3.224065101254679e-17,
+    7.70094837980299e-17, 1.533787661270668e-18, 9.593797919118849e-17, -6.898588935871801e-17,
+    -6.770511658794786e-17, -4.9061748652889893e-17, -9.614213209051323e-17, 7.034914812136422e-18,
+    -9.667293313452913e-17, -1.6077828915890244e-17, -1.2031642489053655e-17, -4.2040340164675566e-17,
+    -3.0237581349939873e-17, -5.779948609396106e-17, -5.600377186075216e-17, 8.465882756533628e-17,
+    -3.483994556892796e-17, 1.0780086764407481e-16, 1.4192920154284036e-17, -6.413767275790235e-17,
+    -1.016455327754295e-16, -4.308699472043341e-17, -1.1024941712342561e-16, 8.875226844438446e-17,
+    7.949834809697621e-17, -1.4600706590689385e-17, 3.7812070533575275e-17, -1.0352061768849722e-16,
+    -1.0136916471278304e-17, -1.9337717034585703e-17, -1.0094406542311964e-16, -6.054917453527784e-17,
+    2.4707192569797888e-17, 2.0941334154229092e-17, -6.712955084707084e-17, 7.698325071319876e-17,
+    -1.0125679913674773e-16, 9.643294303196029e-17, 5.8909926967131e-17, -5.476715964599563e-17,
+    8.199010020581497e-17, -9.66967147439488e-17, -8.0237193703977e-18, -9.868779456632931e-17,
+    -1.851380418263111e-17, -1.0750981861204642e-16, 3.164389299292957e-17, -1.0752290483507515e-16,
+    2.960140695448873e-17, 9.461315018083268e-17, 6.429731796556572e-17, 1.5330400121031314e-17,
+    1.8227458427912087e-17, -5.177222408793318e-17, -9.969531538920349e-17, -1.0159627862277083e-16,
+    3.283107224245627e-17, -5.939742026949965e-17, 9.761887490727594e-17, 6.540912680620572e-17,
+    -6.122763413004143e-17, -8.226593125533711e-17, 3.4034035352165297e-17, 6.533857514718279e-17,
+    -1.0619946056195963e-16, -9.914963769693741e-17, 1.0332385960676326e-16, 6.811022349533877e-17,
+    8.960767791036668e-17, -1.0314928011531132e-16, 4.0388753109278167e-17, 8.2051326383692e-18,
+};
+
+inline double asDouble(int64_t i) { double d; std::memcpy(&d, &i, sizeof(d)); return d; }
+inline int64_t asInt(double d) { int64_t i; std::memcpy(&i, &d, sizeof(i)); return i; }
+
+} // namespace detexp
+
+// Scalar version
+inline double detExp(double x) {
+    using namespace detexp;
+
+    if (x != x)                                 // NaN
+        return x + x;
+    if (x > xMax) x = xMax;
+    if (x < xMin) x = xMin;
+
+    // Argument reduction: k = round(x*N/ln2), r = x - k*ln2/N
+    double z = x*invln2N + shifter;
+    double kd = z - shifter;
+    double r = (x - kd*ln2HIN) - kd*ln2LON;
+    int64_t k = asInt(z) - shifterBits;
+    int64_t j = k & (N-1);
+    int64_t e = k >> 7;                         // k = e*N + j
+    int64_t e1 = e >> 1;
+    int64_t e2 = e - e1;
+
+    // p(r) = exp(r) - 1
+    double r2 = r*r;
+    double p = r + (r2*(C2 + r*C3) + (r2*r2)*(C4 + r*C5));
+
+    // 2^(j/N) * (1 + p) * 2^e1 * 2^e2
+    double y = tabHi[j] + (tabLo[j] + tabHi[j]*p);
+    return (y*asDouble((e1 + 1023) << 52))*asDouble((e2 + 1023) << 52);
+}
+
+#if defined(__GNUC__)
+// SIMD version using the gcc/clang vector extensions: 4 values at a time
+// with AVX, otherwise 2 values at a time (SSE2 on x86, NEON on ARM)
+#if defined(__AVX__)
+const int detExpWidth = 4;
+#else
+const int detExpWidth = 2;
+#endif
+typedef double detExpVdf __attribute__((vector_size(8*detExpWidth)));
+typedef int64_t detExpVdi __attribute__((vector_size(8*detExpWidth)));
+
+inline detExpVdf detExp(detExpVdf x) {
+    using namespace detexp;
+
+    detExpVdi nanMask = (detExpVdi)(x != x);
+    detExpVdi hiMask = (detExpVdi)(x > xMax);
+    detExpVdi loMask = (detExpVdi)(x < xMin);
+    detExpVdf zero = {};
+    detExpVdf xMaxV = zero + xMax;
+    detExpVdf xMinV = zero + xMin;
+    detExpVdf xc = (detExpVdf)(((detExpVdi)x & ~(hiMask | loMask | nanMask)) |
+                                    ((detExpVdi)xMaxV & hiMask) | ((detExpVdi)xMinV & loMask));
+
+    // Argument reduction: k = round(x*N/ln2), r = x - k*ln2/N
+    detExpVdf z = xc*invln2N + shifter;
+    detExpVdf kd = z - shifter;
+    detExpVdf r = (xc - kd*ln2HIN) - kd*ln2LON;
+    detExpVdi k = (detExpVdi)z - shifterBits;
+    detExpVdi j = k & (N-1);
+    detExpVdi e = k >> 7;                       // k = e*N + j
+    detExpVdi e1 = e >> 1;
+    detExpVdi e2 = e - e1;
+
+    // p(r) = exp(r) - 1
+    detExpVdf r2 = r*r;
+    detExpVdf p = r + (r2*(C2 + r*C3) + (r2*r2)*(C4 + r*C5));
+
+    // 2^(j/N) * (1 + p) * 2^e1 * 2^e2
+    detExpVdf th, tl;
+    for (int i = 0; i < detExpWidth; i++) {
+        th[i] = tabHi[j[i]];
+        tl[i] = tabLo[j[i]];
+    }
+    detExpVdf y = th + (tl + th*p);
+    detExpVdf res = (y*(detExpVdf)((e1 + 1023) << 52))*(detExpVdf)((e2 + 1023) << 52);
+
+    return (detExpVdf)(((detExpVdi)res & ~nanMask) | ((detExpVdi)(x + x) & nanMask));
+}
+#endif
+
+// y[i] = exp(x[i]), i = 0..n-1 (x and y can be the same array)
+inline void detExp(const double *x, double *y, std::size_t n) {
+    std::size_t i = 0;
+#if defined(__GNUC__)
+    detExpVdf v;
+    for (; i + detExpWidth <= n; i += detExpWidth) {
+        std::memcpy(&v, x + i, sizeof(v));
+        v = detExp(v);
+        std::memcpy(y + i, &v, sizeof(v));
+    }
+#endif
+    for (; i < n; i++)
+        y[i] = detExp(x[i]);
+}
+
+#endif /* DETEXP_H_ */
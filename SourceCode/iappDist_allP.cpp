@@ -26,7 +26,7 @@ using namespace std;
 void initRandIappValues(std::vector<actualDoubleP> &iapp) {
 
     int numele = iapp.size();
-    if (iapp.size()!=100)
+    if (iapp.size()!=nIappValues)
         return;
 
     iapp[0] = -2.18619;
@@ -134,7 +134,7 @@ void initRandIappValues(std::vector<actualDoubleP> &iapp) {
 }
 
 // Function to write a .txt
-int writeIappToFile (std::string const fileNameStr, std::vector<actualDoubleP> &iapp, int n_p){
+int writeIappToFile (std::string const fileNameStr, const std::vector<actualDoubleP> &iapp, int n_p){
 
     ofstream myfile(fileNameStr);
     unsigned int nNeurons = iapp.size();
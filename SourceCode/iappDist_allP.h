@@ -6,8 +6,10 @@
 
 #include "checkActualPrecision.h"
 
+const unsigned int nIappValues = 100;          // The applied currents are given for 100 neurons
+
 void initRandIappValues(std::vector<actualDoubleP> &iapp);
 
-int writeIappToFile(std::string const fileNameStr, std::vector<actualDoubleP> &iapp, int n_p);
+int writeIappToFile(std::string const fileNameStr, const std::vector<actualDoubleP> &iapp, int n_p);
 
 #endif /* IAPPDIST_H_ */